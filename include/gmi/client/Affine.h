@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gmi/client/Transform.h"
+#include "gmi/math/Rect.h"
 #include "gmi/math/Vec2.h"
 #include <iostream>
 
@@ -178,4 +179,57 @@ inline Vec2f affineApplyInverse(const Affine& m, Vec2f pos) {
     };
 }
 
+/**
+ * Inverts an Affine transformation.
+ * @param m The affine to invert, which must not be degenerate
+ * @return The affine reversing m, with a white color
+ */
+inline Affine affineInverse(const Affine& m) {
+    const float id = 1 / ((m.a * m.d) - (m.b * m.c));
+    Affine result;
+    result.a = m.d * id;
+    result.b = -m.b * id;
+    result.c = -m.c * id;
+    result.d = m.a * id;
+    result.x = ((m.c * m.y) - (m.d * m.x)) * id;
+    result.y = ((m.b * m.x) - (m.a * m.y)) * id;
+    return result;
+}
+
+/**
+ * Applies an Affine transformation to Bounds.
+ * @param m The affine to apply
+ * @param bounds The bounds to apply it to
+ * @return The bounds of the transformed corners. Empty bounds stay empty.
+ */
+inline Bounds affineApplyBounds(const Affine& m, const Bounds& bounds) {
+    if (bounds.empty()) {
+        return bounds;
+    }
+    Bounds result;
+    for (Vec2f corner : {Vec2f{bounds.minX, bounds.minY}, Vec2f{bounds.maxX, bounds.minY}, Vec2f{bounds.minX, bounds.maxY}, Vec2f{bounds.maxX, bounds.maxY}}) {
+        auto [x, y] = affineApply(m, corner);
+        result.extend(x, y);
+    }
+    return result;
+}
+
+/**
+ * Inverts an Affine transformation applied to Bounds.
+ * @param m The affine to reverse
+ * @param bounds The bounds to apply it to
+ * @return The bounds of the transformed corners. Empty bounds stay empty.
+ */
+inline Bounds affineApplyInverseBounds(const Affine& m, const Bounds& bounds) {
+    if (bounds.empty()) {
+        return bounds;
+    }
+    Bounds result;
+    for (Vec2f corner : {Vec2f{bounds.minX, bounds.minY}, Vec2f{bounds.maxX, bounds.minY}, Vec2f{bounds.minX, bounds.maxY}, Vec2f{bounds.maxX, bounds.maxY}}) {
+        auto [x, y] = affineApplyInverse(m, corner);
+        result.extend(x, y);
+    }
+    return result;
+}
+
 }
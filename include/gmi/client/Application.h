@@ -53,6 +53,64 @@ struct ApplicationConfig {
      * If the specified renderer is not available, Glimmerite will automatically fall back to a different one.
      */
     RendererType renderer = RendererType::Count;
+
+    /**
+     * Draws sprites with GPU instancing: each sprite uploads a single 48-byte instance record
+     * instead of four vertices and six indices, and no vertices are expanded on the CPU.
+     * Ignored if the renderer doesn't support instancing.
+     */
+    bool instancedSprites = false;
+
+    /**
+     * How batched vertices are stored in transient buffers. Compact formats store positions relative to an origin
+     * picked per batch and 16-bit texture coordinates, which cuts vertex bandwidth by a third for sprites and by
+     * two thirds for untextured geometry. Drawables far from the batch origin start a new batch.
+     * Texture coordinates must lie within [-1, 1]. Half falls back to Int16 if half-float attributes aren't supported.
+     */
+    VertexFormat vertexFormat = VertexFormat::Float;
+
+    /**
+     * Records drawables during the frame and sorts them before batching, instead of batching them in scene order.
+     * Drawables keep their scene order, except that childless siblings with the same Z index may be reordered by
+     * program and texture to reduce batch breaks.
+     */
+    bool deferred = false;
+
+    /**
+     * The number of extra threads used to batch and submit the scene.
+     * The first level of the scene with at least this many children is split between the threads,
+     * so this should be at most the number of top-level layers or objects. 0 renders on the main thread only.
+     * Ignored in deferred mode.
+     */
+    uint32_t renderThreads = 0;
+
+    /**
+     * Packs individually loaded images into shared atlas pages, so sprites using different images can share a batch.
+     * See @ref TextureManager::enableAtlas().
+     */
+    bool textureAtlas = false;
+
+    /** The width and height of texture atlas pages. */
+    uint32_t atlasPageSize = 2048;
+
+    /**
+     * The maximum absolute error of tween easings evaluated from lookup tables instead of their exact functions.
+     * Only easings using trigonometric or exponential functions are tabulated. 0 always uses the exact functions.
+     */
+    float easingMaxError = 1e-4f;
+
+    /**
+     * Runs without a window, audio device or GPU, for benchmarks and automated tests.
+     * The scene is still updated and batched every frame, but submitted to bgfx's Noop renderer,
+     * and time advances by @ref headlessDt every frame regardless of how long the frame took.
+     */
+    bool headless = false;
+
+    /** In headless mode, the number of frames to run before the Application exits. 0 runs until quit. */
+    uint32_t headlessFrames = 0;
+
+    /** In headless mode, the simulated duration of every frame in milliseconds. */
+    float headlessDt = 1000.0f / 60.0f;
 };
 
 using EventListener = std::function<void(const SDL_Event&)>;
@@ -82,6 +140,12 @@ public:
     /** @return The @ref Renderer associated with the Application */
     [[nodiscard]] Renderer& renderer() { return m_renderer; }
 
+    /** @return The pools children created with @ref Container::createPooledChild() are allocated from */
+    [[nodiscard]] NodePools& nodePools() { return m_nodePools; }
+
+    /** @return The occupancy of every node pool, see @ref Container::createPooledChild(). */
+    [[nodiscard]] std::vector<PoolStats> getNodePoolStats() const { return m_nodePools.getStats(); }
+
     /** @return The root Container of the Application */
     Container& stage() { return m_stage; }
 
@@ -102,6 +166,18 @@ public:
     /** @return Delta time (time elapsed since previous frame) in milliseconds. */
     [[nodiscard]] float getDt() const { return m_dt; }
 
+    /**
+     * @return The time of the current frame in milliseconds, which animations are timed with.
+     * Simulated in headless mode, starting at 0.
+     */
+    [[nodiscard]] uint64_t getTime() const { return m_time; }
+
+    /** @return The number of frames rendered so far. */
+    [[nodiscard]] uint64_t getFrameCount() const { return m_frameCount; }
+
+    /** @return Whether the Application runs without a window, see @ref ApplicationConfig::headless. */
+    [[nodiscard]] bool isHeadless() const { return m_headless; }
+
     /**
      * Registers a function to be called every frame.
      * @param ticker The ticker function
@@ -133,15 +209,15 @@ public:
     [[nodiscard]] math::Size getSize() const;
 
     /** @param size The Size to set the Application window to */
-    void setSize(math::Size size) const;
+    void setSize(math::Size size);
 
     /**
      * @param width The width to set the Application window to
      * @param height The height to set the Application window to
      */
-    void setSize(int width, int height) const;
+    void setSize(int width, int height);
 
-    /** @return The window object backing this Application, or nullptr if it hasn't been initialized yet */
+    /** @return The window object backing this Application, or nullptr if it hasn't been initialized yet or is headless */
     [[nodiscard]] SDL_Window* getWindow() const { return m_window; }
 
     /** This method is called internally once per frame and should never be called manually. */
@@ -151,16 +227,24 @@ public:
     SDL_AppResult processEvent(SDL_Event* event);
 
     /** This method is called internally when the program terminates and should never be called manually. */
-    void shutdown(SDL_AppResult result) const;
+    void shutdown(SDL_AppResult result);
 private:
     bool m_initialized = false;
 
     SDL_Window* m_window = nullptr;
 
+    bool m_headless = false;
+    uint32_t m_headlessFrames = 0;
+    float m_headlessDt = 0.0f;
+    math::Size m_headlessSize;
+    double m_headlessTime = 0.0;
+
     uint16_t m_maxFps = 0;
     bool m_firstRun = true;
     std::chrono::time_point<std::chrono::steady_clock> m_lastFrame;
     float m_dt = 0.0f;
+    uint64_t m_time = 0;
+    uint64_t m_frameCount = 0;
 
     std::vector<std::function<void()>> m_tickers;
     std::unordered_map<Uint32, EventListener> m_eventListeners;
@@ -171,6 +255,8 @@ private:
     SoundManager m_soundManager;
     TweenManager m_tweenManager;
     Renderer m_renderer;
+    // declared before the stage, so pooled nodes are destroyed before their slabs
+    NodePools m_nodePools;
     Container m_stage;
 };
 
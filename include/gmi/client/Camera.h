@@ -0,0 +1,35 @@
+#pragma once
+#include "gmi/client/Container.h"
+
+namespace gmi {
+
+/**
+ * A Container whose own transform is applied on the GPU rather than to its descendants.
+ * Panning, zooming or rotating a Camera through its position, scale and rotation doesn't update the transforms of
+ * its children: they are laid out in the camera's space, and the camera's transform is applied to each of their draw
+ * calls as a model matrix. Use it in place of a world Container that is scrolled by moving it.
+ *
+ * Tints still propagate to the children on the CPU. Bounds of the children are in the camera's space.
+ */
+class Camera final : public Container {
+public:
+    Camera(Application* parentApp, Container* parent, const math::Transform& transform = {});
+
+    /** @return The transform from the camera's space to the space of its parent, as of the last transform update. */
+    [[nodiscard]] const math::Affine& getViewAffine() const { return m_viewAffine; }
+
+    /**
+     * Converts a point from the camera's parent space, such as screen coordinates, to the camera's space.
+     * @param point The point to convert
+     * @return The point in the camera's space
+     */
+    [[nodiscard]] math::Vec2f toLocal(math::Vec2f point) const { return math::affineApplyInverse(m_viewAffine, point); }
+protected:
+    void updateAffine() override;
+    void updateBounds() override;
+    void renderContent(Renderer& renderer) override;
+private:
+    math::Affine m_viewAffine;
+};
+
+}
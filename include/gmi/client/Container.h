@@ -1,12 +1,16 @@
 #pragma once
 #include <memory>
+#include <span>
 #include <vector>
 #include <unordered_map>
 
+#include "gmi/client/NodePool.h"
 #include "gmi/client/Renderer.h"
+#include "gmi/client/TweenManager.h"
 
 #include "gmi/client/Affine.h"
 #include "gmi/math/Easing.h"
+#include "gmi/math/Rect.h"
 
 namespace gmi {
 
@@ -24,6 +28,7 @@ class Application;
 class Renderer;
 
 class Container {
+    friend struct ContainerDeleter;
 public:
     Container() = default;
 
@@ -33,13 +38,16 @@ public:
     Container(Application* parentApp, Container* parent, const math::Transform& transform) :
         m_parentApp(parentApp), m_parent(parent), m_transform(transform) { }
 
-    virtual ~Container() = default;
+    virtual ~Container();
 
     /** @return A pointer to this Container's parent, or `nullptr` if it does not have a parent. */
     [[nodiscard]] Container* getParent() const { return m_parent; }
 
-    /** @return A const reference to a std::vector containing this Container's children. */
-    [[nodiscard]] const std::vector<std::unique_ptr<Container>>& getChildren() const { return m_children; }
+    /** @return A const reference to a std::vector containing this Container's children, ordered by Z index. */
+    [[nodiscard]] const std::vector<ContainerPtr>& getChildren() const {
+        compactChildren();
+        return m_children;
+    }
 
     /**
      * Creates a child and adds it to this Container.
@@ -51,19 +59,51 @@ public:
     template<typename T, typename... Args>
     T& createChild(Args&&... args) {
         auto childPtr = new T(m_parentApp, this, std::forward<Args>(args)...);
-        m_children.emplace_back(childPtr);
+        adoptChild(childPtr);
+        return *childPtr;
+    }
+
+    /**
+     * Creates a child from the Application's pool for its type, and adds it to this Container.
+     * Nodes of the same type are allocated next to each other, and the memory of removed nodes is reused,
+     * which suits nodes that are created and removed in large numbers, such as bullets and particles.
+     * @tparam T The type of Container to create
+     * @tparam Args The Container's constructor arguments
+     * @param args The arguments to pass to the Container's constructor
+     * @return A pointer to the newly created Container
+     */
+    template<typename T, typename... Args>
+    T& createPooledChild(Args&&... args) {
+        NodePool<T>& pool = nodePools().template get<T>();
+        T* childPtr = pool.create(m_parentApp, this, std::forward<Args>(args)...);
+        childPtr->m_pool = &pool;
+        adoptChild(childPtr);
         return *childPtr;
     }
 
     /**
-     * Removes a child from this Container.
-     * @param child The child to remove
+     * Removes this Container from its parent and destroys it, returning its memory to its pool if it was created
+     * with @ref createPooledChild(). Equivalent to calling @ref removeChild() on the parent.
+     */
+    void release();
+
+    /**
+     * Removes and destroys a child of this Container in constant time.
+     * Its slot is only reclaimed by the next transform update, so removing many children in a frame stays linear.
+     * @param child The child to remove. Nothing happens if it is not a child of this Container.
      */
     void removeChild(Container* child);
 
     /**
-     * Sorts this Container's children by Z index.
-     * Setting Z index of a child has no effect until this method is called.
+     * Removes and destroys several children of this Container, see @ref removeChild().
+     * @param children The children to remove
+     */
+    void removeChildren(std::span<Container* const> children);
+
+    /**
+     * Sorts this Container's children by Z index right away.
+     * This happens automatically on the next transform update after a Z index changed, so calling it is only
+     * needed to observe the new order before then.
      */
     void sortChildren();
 
@@ -91,8 +131,40 @@ public:
     /** @param pivot The center of rotation to set, as a normalized vector (components 0-1) */
     void setPivot(math::Vec2f pivot);
 
-    /** @param visible Whether the Container should be visible */
-    void setVisible(bool visible) { m_visible = visible; }
+    /**
+     * Shows or hides this Container and its children.
+     * The transforms of hidden subtrees are only updated once they are shown again.
+     * @param visible Whether the Container should be visible
+     */
+    void setVisible(bool visible);
+
+    /** @return Whether this Container is visible, see @ref setVisible(). */
+    [[nodiscard]] bool isVisible() const { return m_visible; }
+
+    /**
+     * @return Whether this Container and its children are drawn: it must be visible, and its tint, combined with its
+     * ancestors' as of the last transform update, must not be fully transparent.
+     */
+    [[nodiscard]] bool isRendered() const { return m_visible && m_affine.color.a > 0; }
+
+    /**
+     * Renders this Container and its children into a texture, which is then drawn as a single quad.
+     * The texture is rendered in this Container's local space and only re-rendered when something inside the subtree
+     * changes, or when the tint inherited from its ancestors does. Moving, rotating or scaling this Container or its
+     * ancestors only moves the quad, so this suits subtrees that rarely change internally, such as UI panels or
+     * static decorations in a scrolling world. Scaling the Container up magnifies the texture.
+     * @param cache Whether to cache this Container as a texture
+     */
+    void setCacheAsTexture(bool cache);
+
+    /** @return Whether this Container is cached as a texture, see @ref setCacheAsTexture(). */
+    [[nodiscard]] bool isCachedAsTexture() const { return m_cache != nullptr; }
+
+    /** @return The world-space Affine of this Container, as of the last transform update. */
+    [[nodiscard]] const math::Affine& getAffine() const { return m_affine; }
+
+    /** @return A counter that is incremented whenever @ref getAffine() changes, so dependents can tell if they are stale. */
+    [[nodiscard]] uint32_t getWorldVersion() const { return m_worldVersion; }
 
     /** @return The Transform applied to this Container (position, rotation, scale, etc.) */
     [[nodiscard]] const math::Transform& getTransform() const { return m_transform; }
@@ -101,11 +173,10 @@ public:
     [[nodiscard]] int getZIndex() const { return m_zIndex; }
 
     /**
-     * Sets the Z index of this Container.
-     * IMPORTANT: This value will not be respected until sortChildren() is called on the parent.
+     * Sets the Z index of this Container. Its parent's children are re-sorted on the next transform update.
      * @param zIndex The new Z index to set
      */
-    void setZIndex(int zIndex) { m_zIndex = zIndex; }
+    void setZIndex(int zIndex);
 
     void animate(const AnimateOptions<math::Vec2f>& opts);
 
@@ -113,27 +184,129 @@ public:
 
     void stopAnimate(math::TransformProps prop);
 
+    /** @return The world-space bounds of this Container and its children, as of the last frame. */
+    [[nodiscard]] const math::Bounds& getBounds() const { return m_bounds; }
+
+    /**
+     * Updates the transforms and bounds of this Container and its children.
+     * Only subtrees that changed are visited, and only Containers whose own transform or an ancestor's world
+     * transform changed are recomputed.
+     */
+    void updateTransforms();
+
     /**
      * Renders the contents of this Container using the given @ref Renderer.
+     * Nothing is rendered if the Container's bounds are outside the renderer's view.
      * @param renderer The renderer to use
      */
     virtual void render(Renderer& renderer);
 protected:
+    /**
+     * Renders this Container's children, once @ref render() has checked that it is visible and not drawn from its
+     * texture cache.
+     * @param renderer The renderer to use
+     */
+    virtual void renderContent(Renderer& renderer);
+
+    /**
+     * Renders one child from @ref renderContent(), starting a new run of equal Z indices if its Z index differs from
+     * the previous child's.
+     */
+    void renderChild(Renderer& renderer, Container& child);
+
+    /**
+     * Takes the draw order of a drawable this Container queues now, see @ref Renderer::nextDrawOrder().
+     * Childless Containers share the order of their run of equal-Z siblings, so deferred mode may reorder them by
+     * program and texture. Any other drawable takes the next order, which keeps its subtree in scene order.
+     */
+    [[nodiscard]] uint32_t drawOrder(Renderer& renderer) const;
+
     Application* m_parentApp = nullptr;
     Container* m_parent = nullptr;
-    std::vector<std::unique_ptr<Container>> m_children;
+    /**
+     * Children ordered by Z index, then by insertion. Removed children leave a null tombstone until
+     * @ref compactChildren(), which runs before any traversal, so traversals never see them.
+     */
+    mutable std::vector<ContainerPtr> m_children;
+    mutable uint32_t m_removedChildren = 0;
+    mutable bool m_childOrderDirty = false;
+    /** The index of this Container in its parent's children. */
+    uint32_t m_childIndex = 0;
+    /** The pool this Container was allocated from, or `nullptr` if it was allocated on the heap. */
+    NodePoolBase* m_pool = nullptr;
+
+    /** Takes ownership of a newly created child. */
+    void adoptChild(Container* child);
+
+    /** @return The node pools of the Application. */
+    [[nodiscard]] NodePools& nodePools() const;
+
+    /** Drops tombstones and restores Z order after children were removed or re-ordered. */
+    void compactChildren() const;
 
     math::Affine m_affine;
     math::Transform m_transform;
     bool m_transformDirty = true;
+    /** Incremented whenever the local state of this Container (transform, visibility) is modified. */
+    uint32_t m_localVersion = 0;
+    /** Incremented whenever @ref m_affine changes. Zero until the first transform update. */
+    uint32_t m_worldVersion = 0;
+    /** The parent's world version that @ref m_affine was computed from. */
+    uint32_t m_parentWorldVersion = 0;
+
+    // World-space bounds of this subtree. A dirty Container implies dirty ancestors.
+    math::Bounds m_bounds;
+    bool m_boundsDirty = true;
+    /**
+     * Whether something in this subtree changed other than this Container's own transform, such as a descendant's
+     * transform, content or children. Like bounds, a dirty Container implies dirty ancestors.
+     */
+    bool m_subtreeDirty = true;
+    /**
+     * Set by @ref render() if subclasses must not draw their content,
+     * because this Container is outside the view or drawn from its texture cache.
+     */
+    bool m_skipDraw = false;
+
+    std::unique_ptr<RenderCache> m_cache;
 
     int m_zIndex = 0;
+    /** The draw order shared by the childless children in the current run of equal Z indices, 0 before the first. */
+    uint32_t m_runOrder = 0;
+    int m_runZIndex = 0;
     bool m_visible = true;
 
-    std::unordered_map<math::TransformProps, uint16_t> m_animations;
-    void removeAnim(uint16_t id);
+    std::unordered_map<math::TransformProps, TweenHandle> m_animations;
+    void addAnim(math::TransformProps prop, TweenOptions opts);
+
+    /** Marks the transform of this Container as changed, which also invalidates its bounds. */
+    void markTransformDirty();
+
+    /** Invalidates the bounds of this Container and its ancestors, after its content or children changed. */
+    void markBoundsDirty();
+
+    /**
+     * Invalidates the bounds of this Container and its ancestors.
+     * @param changed The first Container whose subtree changed, which is this Container or its parent
+     */
+    void markDirty(Container* changed);
+
+    /** @return The world-space bounds of this Container's own content, excluding children. */
+    [[nodiscard]] virtual math::Bounds getContentBounds() { return {}; }
+
+    /** Recomputes the bounds of this Container from its content and children, updating the children first. */
+    virtual void updateBounds();
 
+    /**
+     * Recomputes the world-space Affine of this Container from its transform and its parent's Affine.
+     * @ref m_worldVersion is only incremented if the result differs, so unchanged descendants are left alone.
+     */
     virtual void updateAffine();
+
+    /** @return Whether this Container's Affine is stale, because its transform or its parent's Affine changed. */
+    [[nodiscard]] bool isAffineStale() const {
+        return m_transformDirty || (m_parent != nullptr && m_parentWorldVersion != m_parent->m_worldVersion);
+    }
 };
 
 }
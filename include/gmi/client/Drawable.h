@@ -3,14 +3,27 @@
 #include "bgfx/bgfx.h"
 #include "gmi/client/Vertex.h"
 
+#include <cstdint>
 #include <vector>
 
 namespace gmi {
 
 struct Drawable {
     std::vector<Vertex> vertices;
-    std::vector<uint16_t> indices;
+    std::vector<uint32_t> indices;
     bgfx::TextureHandle texture = BGFX_INVALID_HANDLE;
 };
 
+/**
+ * A quad with inline storage, so it can be rebuilt without allocating.
+ * It is drawn with the shared index pattern @ref QUAD_INDICES.
+ */
+struct Quad {
+    Vertex vertices[4];
+    bgfx::TextureHandle texture = BGFX_INVALID_HANDLE;
+};
+
+/** The indices of the two triangles of a @ref Quad, whose vertices go clockwise from the top left. */
+inline constexpr uint16_t QUAD_INDICES[6] = {0, 1, 2, 0, 2, 3};
+
 }
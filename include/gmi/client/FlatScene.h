@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmi/client/Container.h"
+#include "gmi/client/TextureManager.h"
+
+namespace gmi {
+
+namespace internal {
+struct QuadArrays;
+}
+
+/** A handle to a node of a @ref FlatScene. Handles stay valid while nodes are added and removed around them. */
+struct NodeHandle {
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint32_t id = INVALID;
+    uint32_t generation = 0;
+
+    [[nodiscard]] bool valid() const { return id != INVALID; }
+};
+
+/**
+ * A Container holding a lightweight scene of its own, for scenes with too many nodes to afford a Container each.
+ * Transforms, world affines, parent indices and flags live in contiguous arrays kept in hierarchy order, so every
+ * parent precedes its descendants. World transforms are then propagated in a single linear pass over the dirty nodes
+ * and their descendants, without recursion or virtual calls.
+ * The quads of visible sprites are cached between frames. Moving or tinting nodes regenerates the quads of the changed
+ * sprites only, while creating, destroying, showing or hiding sprites, or transforming the FlatScene itself,
+ * regenerates every quad. A group node costs about a hundred bytes, and a visible sprite node about 250 including its
+ * cached quad and the kernel's inputs.
+ *
+ * Nodes are addressed through @ref NodeHandle and either group other nodes or draw a sprite. They are drawn in
+ * hierarchy order, have no Z index, and aren't animated by the TweenManager.
+ * Nodes created after their parent's last descendant are appended in constant time; creating a node in an earlier
+ * subtree, or destroying one, moves the nodes after it.
+ */
+class FlatScene final : public Container {
+public:
+    FlatScene(Application* parentApp, Container* parent, const math::Transform& transform = {});
+    ~FlatScene() override;
+
+    /**
+     * Creates a node which groups other nodes.
+     * @param parent The parent node, or an invalid handle to create a root node
+     * @param transform The node's transform, relative to its parent
+     * @return The new node
+     */
+    NodeHandle createNode(NodeHandle parent = {}, const math::Transform& transform = {});
+
+    /**
+     * Creates a node which draws a sprite.
+     * @param textureName The name of the sprite's texture
+     * @param parent The parent node, or an invalid handle to create a root node
+     * @param transform The node's transform, relative to its parent
+     * @return The new node
+     */
+    NodeHandle createSprite(const std::string& textureName, NodeHandle parent = {}, const math::Transform& transform = {});
+
+    /**
+     * Destroys a node and its descendants, invalidating their handles.
+     * @param node The node to destroy
+     */
+    void destroy(NodeHandle node);
+
+    /** @return Whether the handle refers to a live node of this scene. */
+    [[nodiscard]] bool isValid(NodeHandle node) const;
+
+    /** @return The number of live nodes. */
+    [[nodiscard]] size_t size() const { return m_local.size(); }
+
+    /** @return The transform of a node, relative to its parent. */
+    [[nodiscard]] const math::Transform& getTransform(NodeHandle node) const { return m_local[indexOf(node)]; }
+
+    /** @return The world-space affine of a node, as of the last transform update. */
+    [[nodiscard]] const math::Affine& getWorldAffine(NodeHandle node) const { return m_world[indexOf(node)]; }
+
+    void setPosition(NodeHandle node, math::Vec2f position);
+    void setRotation(NodeHandle node, float rotation);
+    void setScale(NodeHandle node, math::Vec2f scale);
+    void setTint(NodeHandle node, Color tint);
+    void setPivot(NodeHandle node, math::Vec2f pivot);
+
+    /** Hides or shows a node and its descendants. */
+    void setVisible(NodeHandle node, bool visible);
+protected:
+    void updateAffine() override;
+    void updateBounds() override;
+    [[nodiscard]] math::Bounds getContentBounds() override { return m_contentBounds; }
+    void renderContent(Renderer& renderer) override;
+private:
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    enum Flags : uint8_t {
+        DIRTY = 1 << 0,
+        VISIBLE = 1 << 1,
+        /** Set by the propagation pass if the node or one of its ancestors is hidden. */
+        HIDDEN = 1 << 2,
+    };
+
+    // Node data, indexed in hierarchy order
+    std::vector<math::Transform> m_local;
+    std::vector<math::Affine> m_world;
+    std::vector<uint32_t> m_parents;
+    /** The number of nodes in each node's subtree, including itself. */
+    std::vector<uint32_t> m_subtreeSizes;
+    std::vector<uint8_t> m_flags;
+    /** The texture each node draws, or `nullptr` for group nodes. */
+    std::vector<const Texture*> m_textures;
+    std::vector<uint32_t> m_ids;
+
+    // Handle ids map to node indices through a table, since indices shift as nodes are added and removed
+    std::vector<uint32_t> m_idToIndex;
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_freeIds;
+
+    uint32_t m_dirtyCount = 0;
+    /** Set when the FlatScene's own affine changed, so every node must be updated. */
+    bool m_allDirty = true;
+    /** Set when sprites were created, destroyed, shown or hidden, so every quad must be regenerated. */
+    bool m_quadsStale = false;
+    math::Bounds m_contentBounds;
+
+    // Scratch buffers reused every frame
+    std::vector<uint8_t> m_changed;
+    std::vector<Vertex> m_runVertices;
+
+    // Quads of the visible sprite nodes in hierarchy order, updated by the propagation pass in one batched call
+    std::unique_ptr<internal::QuadArrays> m_quadInputs;
+    std::vector<uint32_t> m_quadNodes;
+    std::vector<Vertex> m_quads;
+    // The quads regenerated by a partial update, and their new vertices
+    std::vector<uint32_t> m_changedQuads;
+    std::vector<Vertex> m_changedVertices;
+
+    [[nodiscard]] uint32_t indexOf(NodeHandle node) const;
+    NodeHandle insertNode(NodeHandle parent, const math::Transform& transform, const Texture* texture);
+    void markDirty(uint32_t index);
+    void propagate();
+    void pushQuad(uint32_t index);
+    void rebuildQuads();
+    void updateChangedQuads();
+    void flushRun(Renderer& renderer, bgfx::TextureHandle texture, const math::Bounds& area);
+};
+
+}
@@ -35,6 +35,8 @@ class Graphics : public Container {
 public:
     Graphics(Application* parentApp, Container* parent) : Container(parentApp, parent) { }
 
+    ~Graphics() override;
+
     Graphics& clear();
 
     Graphics& drawLine(std::vector<math::Vec2f> points, const StrokeStyle& style);
@@ -50,8 +52,25 @@ public:
     Graphics& fillShape(const collision::Shape& shape, Color color);
 
     void render(Renderer& renderer) override;
+protected:
+    [[nodiscard]] math::Bounds getContentBounds() override;
 private:
     Drawable m_drawable;
+
+    // Geometry that stays unchanged for a frame is moved into static GPU buffers,
+    // which are only re-uploaded once the geometry changes again
+    uint32_t m_version = 0;
+    uint32_t m_renderedVersion = UINT32_MAX;
+    uint32_t m_uploadedVersion = UINT32_MAX;
+    bgfx::VertexBufferHandle m_staticVertices = BGFX_INVALID_HANDLE;
+    bgfx::IndexBufferHandle m_staticIndices = BGFX_INVALID_HANDLE;
+
+    math::Bounds m_vertexBounds;
+    uint32_t m_boundsVersion = UINT32_MAX;
+
+    void markGeometryDirty();
+    void uploadStatic(Renderer& renderer);
+    void destroyStatic();
 };
 
 }
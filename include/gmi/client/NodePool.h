@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace gmi {
+
+class Container;
+
+/** Destroys a Container, returning its memory to its @ref NodePool if it was created from one. */
+struct ContainerDeleter {
+    void operator()(Container* container) const;
+};
+
+/** Owning pointer to a Container, as stored in its parent's children. */
+using ContainerPtr = std::unique_ptr<Container, ContainerDeleter>;
+
+/** Occupancy of a @ref NodePool. */
+struct PoolStats {
+    /** The implementation-defined name of the pooled type. */
+    std::string_view type;
+    /** The number of nodes the pool's slabs can hold. */
+    uint32_t capacity = 0;
+    /** The number of nodes currently alive. */
+    uint32_t inUse = 0;
+    /** The number of slabs allocated. */
+    uint32_t slabs = 0;
+};
+
+class NodePoolBase {
+public:
+    virtual ~NodePoolBase() = default;
+
+    /**
+     * Destroys a node created by this pool and makes its memory available to the next one.
+     * @param node The node
+     */
+    virtual void recycle(Container* node) = 0;
+
+    /** @return The pool's occupancy. */
+    [[nodiscard]] const PoolStats& getStats() const { return m_stats; }
+protected:
+    PoolStats m_stats;
+};
+
+/**
+ * Allocates nodes of a single type from fixed-size slabs, so nodes of the same type sit next to each other in memory
+ * and churning nodes reuses the same memory instead of going through the heap.
+ * @tparam T The type of Container to pool
+ */
+template<typename T>
+class NodePool final : public NodePoolBase {
+public:
+    /** The number of nodes per slab. */
+    static constexpr uint32_t SLAB_SIZE = 256;
+
+    NodePool() { m_stats.type = typeid(T).name(); }
+
+    /**
+     * Constructs a node in a free slot, allocating a new slab if all slots are taken.
+     * @param args The arguments to pass to the node's constructor
+     * @return The node
+     */
+    template<typename... Args>
+    T* create(Args&&... args) {
+        if (m_free.empty()) {
+            allocSlab();
+        }
+        Slot* slot = m_free.back();
+        m_free.pop_back();
+        try {
+            T* node = new (slot->storage) T(std::forward<Args>(args)...);
+            m_stats.inUse++;
+            return node;
+        } catch (...) {
+            m_free.push_back(slot);
+            throw;
+        }
+    }
+
+    void recycle(Container* node) override {
+        auto* object = static_cast<T*>(node);
+        object->~T();
+        m_free.push_back(reinterpret_cast<Slot*>(object));
+        m_stats.inUse--;
+    }
+private:
+    struct Slot {
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+    std::vector<std::unique_ptr<Slot[]>> m_slabs;
+    std::vector<Slot*> m_free;
+
+    void allocSlab() {
+        Slot* slab = m_slabs.emplace_back(std::make_unique_for_overwrite<Slot[]>(SLAB_SIZE)).get();
+        // pushed in reverse, so consecutive creations fill the slab front to back
+        for (uint32_t i = SLAB_SIZE; i > 0; i--) {
+            m_free.push_back(&slab[i - 1]);
+        }
+        m_stats.capacity += SLAB_SIZE;
+        m_stats.slabs++;
+    }
+};
+
+/** The node pools of an Application, one per pooled type. */
+class NodePools {
+public:
+    /** @return The pool for nodes of type T, which is created on first use. */
+    template<typename T>
+    NodePool<T>& get() {
+        std::unique_ptr<NodePoolBase>& pool = m_pools[std::type_index(typeid(T))];
+        if (pool == nullptr) {
+            pool = std::make_unique<NodePool<T>>();
+        }
+        return static_cast<NodePool<T>&>(*pool);
+    }
+
+    /** @return The occupancy of every pool. */
+    [[nodiscard]] std::vector<PoolStats> getStats() const {
+        std::vector<PoolStats> stats;
+        stats.reserve(m_pools.size());
+        for (const auto& pool : m_pools | std::views::values) {
+            stats.push_back(pool->getStats());
+        }
+        return stats;
+    }
+private:
+    std::unordered_map<std::type_index, std::unique_ptr<NodePoolBase>> m_pools;
+};
+
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "gmi/client/Container.h"
+#include "gmi/client/TextureManager.h"
+
+namespace gmi {
+
+namespace internal {
+struct QuadArrays;
+}
+
+/** The state of a single particle of a @ref ParticleContainer. */
+struct Particle {
+    /** The position of the particle's pivot, in the ParticleContainer's space. */
+    math::Vec2f position;
+    /** The rotation about the pivot, in radians. */
+    float rotation = 0;
+    math::Vec2f scale = {1, 1};
+    Color tint = Color::White;
+    /** The index of the frame to draw, among the frames the ParticleContainer was created with. */
+    uint16_t frame = 0;
+};
+
+/**
+ * A Container drawing a large number of particles, which are plain data rather than scene nodes.
+ * Particles are stored as parallel arrays, all share one texture, and are written straight into the renderer's
+ * batch as quads, with no per-particle virtual calls, allocations or culling. Quads are generated by a SIMD kernel.
+ * In deferred mode, particles keep their scene order, but aren't sorted with other drawables, see
+ * @ref Renderer::reserve().
+ *
+ * Particles are addressed by index. Removing a particle moves the last one into its place, so indices are only
+ * stable until the next removal.
+ */
+class ParticleContainer final : public Container {
+public:
+    /**
+     * Creates a ParticleContainer whose particles all draw the same texture.
+     * @param textureName The name of the texture
+     */
+    ParticleContainer(Application* parentApp, Container* parent, const std::string& textureName, const math::Transform& transform = {});
+
+    /**
+     * Creates a ParticleContainer whose particles draw one of several frames, such as frames of a spritesheet.
+     * @param frameNames The names of the frames, which must be stored in the same texture
+     * @throws GmiException if the frames are stored in different textures
+     */
+    ParticleContainer(Application* parentApp, Container* parent, const std::vector<std::string>& frameNames, const math::Transform& transform = {});
+
+    ~ParticleContainer() override;
+
+    /**
+     * Adds a particle.
+     * @param particle The particle
+     * @return The index of the particle
+     * @throws GmiException if the particle's frame does not exist
+     */
+    uint32_t add(const Particle& particle);
+
+    /**
+     * Removes a particle in constant time, by moving the last particle into its place.
+     * @param index The index of the particle
+     */
+    void remove(uint32_t index);
+
+    /** Removes every particle. */
+    void clear();
+
+    /** @param capacity The number of particles to allocate memory for */
+    void reserve(uint32_t capacity);
+
+    /** @return The number of particles. */
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(m_positions.size()); }
+
+    /** @return A copy of the particle at the given index. */
+    [[nodiscard]] Particle get(uint32_t index) const;
+
+    /**
+     * Replaces the particle at the given index.
+     * @param index The index of the particle
+     * @param particle The new state of the particle
+     */
+    void set(uint32_t index, const Particle& particle);
+
+    // Direct access to the particle arrays, for updating many particles in a tight loop.
+    // Call markChanged() after writing to them.
+    [[nodiscard]] std::span<math::Vec2f> getPositions() { return m_positions; }
+    [[nodiscard]] std::span<float> getRotations() { return m_rotations; }
+    [[nodiscard]] std::span<math::Vec2f> getScales() { return m_scales; }
+    [[nodiscard]] std::span<Color> getTints() { return m_tints; }
+    [[nodiscard]] std::span<uint16_t> getFrames() { return m_frames; }
+
+    /** Marks the particles as changed after they were written through the arrays, so the bounds are recomputed. */
+    void markChanged() { markBoundsDirty(); }
+
+    /** @param pivot The center of rotation of every particle, as a normalized vector (components 0-1) */
+    void setParticlePivot(math::Vec2f pivot);
+protected:
+    [[nodiscard]] math::Bounds getContentBounds() override;
+    void renderContent(Renderer& renderer) override;
+private:
+    struct Frame {
+        float u0, v0, u1, v1;
+        float w, h;
+    };
+    bgfx::TextureHandle m_texture = BGFX_INVALID_HANDLE;
+    std::vector<Frame> m_frameData;
+    /** The largest distance from the pivot to a corner among all frames, at a scale of 1. */
+    float m_maxExtent = 0;
+    math::Vec2f m_pivot = {0.5f, 0.5f};
+
+    // Particle data, indexed by particle
+    std::vector<math::Vec2f> m_positions;
+    std::vector<float> m_rotations;
+    std::vector<math::Vec2f> m_scales;
+    std::vector<Color> m_tints;
+    std::vector<uint16_t> m_frames;
+
+    // Scratch buffers reused every frame: the world affine of every particle, and vertices for compact formats
+    std::unique_ptr<internal::QuadArrays> m_quadInputs;
+    std::vector<Vertex> m_vertices;
+
+    void addFrame(const Texture& texture);
+    void updateMaxExtent();
+};
+
+}
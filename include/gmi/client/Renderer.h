@@ -1,9 +1,16 @@
 #pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <vector>
 
+#include "Affine.h"
 #include "Color.h"
 #include "Drawable.h"
+#include "NodePool.h"
 #include "bgfx/bgfx.h"
+#include "gmi/math/Rect.h"
 
 namespace gmi {
 
@@ -11,6 +18,10 @@ class Application;
 struct ApplicationConfig;
 class Container;
 
+namespace internal {
+class WorkerPool;
+}
+
 using RendererType = bgfx::RendererType::Enum;
 
 enum class Antialiasing : uint8_t {
@@ -21,13 +32,151 @@ enum class Antialiasing : uint8_t {
     None
 };
 
+/**
+ * The maximum number of quads to reserve in one @ref BatchSpan, so a run of quads is always addressable by
+ * 16-bit indices.
+ */
+inline constexpr uint32_t MAX_RUN_QUADS = (UINT16_MAX + 1) / 4;
+
+/**
+ * A range of transient vertex and index memory reserved in the current batch.
+ * Vertices and indices are written straight into it, without any intermediate copy.
+ */
+struct BatchSpan {
+    /** The first reserved vertex, or `nullptr` if the renderer ran out of transient memory. Write through @ref setVertex. */
+    void* vertices = nullptr;
+    /** The first reserved index. Points to `uint32_t`s if @ref index32 is set, otherwise to `uint16_t`s. */
+    void* indices = nullptr;
+    /** Index of the first reserved vertex relative to the start of the batch. Added to every index written. */
+    uint32_t baseVertex = 0;
+    /** Whether the batch uses 32-bit indices. */
+    bool index32 = false;
+    /** The texture slot the reserved vertices must sample from, see @ref Vertex::textureSlot. */
+    float textureSlot = 0;
+
+    /** The format the reserved vertices are stored in. */
+    VertexFormat format = VertexFormat::Float;
+    /** Whether the vertices are textured. Untextured compact vertices only store a position and a color. */
+    bool textured = false;
+    /** The origin compact positions are relative to. */
+    float originX = 0, originY = 0;
+    /** Compact position units per pixel. */
+    float unitsPerPixel = 1;
+
+    /**
+     * Writes a vertex into the reserved memory, converting it to the batch's format.
+     * @param i The position of the vertex in the span
+     * @param vertex The vertex. Its texture slot is replaced by @ref textureSlot.
+     */
+    void setVertex(uint32_t i, const Vertex& vertex) const {
+        if (format == VertexFormat::Float) {
+            Vertex* out = static_cast<Vertex*>(vertices) + i;
+            *out = vertex;
+            out->textureSlot = textureSlot;
+        } else {
+            setCompactVertex(i, vertex);
+        }
+    }
+
+    /**
+     * Writes an index into the reserved memory.
+     * @param i The position of the index in the span
+     * @param index The index, relative to the first reserved vertex
+     */
+    void setIndex(uint32_t i, uint32_t index) const {
+        if (index32) {
+            static_cast<uint32_t*>(indices)[i] = baseVertex + index;
+        } else {
+            static_cast<uint16_t*>(indices)[i] = static_cast<uint16_t>(baseVertex + index);
+        }
+    }
+
+private:
+    void setCompactVertex(uint32_t i, const Vertex& vertex) const;
+};
+
+/** How drawn pixels are combined with the pixels behind them. */
+enum class BlendMode : uint8_t {
+    /** Regular alpha blending, for colors that are not premultiplied by their alpha. */
+    Alpha,
+    /** For colors that are already premultiplied by their alpha, such as the contents of a @ref RenderCache. */
+    Premultiplied
+};
+
+/** A Container rendered into a texture, see @ref Container::setCacheAsTexture(). */
+struct RenderCache {
+    bgfx::FrameBufferHandle frameBuffer = BGFX_INVALID_HANDLE;
+    /** The color attachment of @ref frameBuffer, holding premultiplied colors. */
+    bgfx::TextureHandle texture = BGFX_INVALID_HANDLE;
+    uint16_t width = 0, height = 0;
+    /** The area the texture was rendered from, in the Container's local space. */
+    math::Bounds area;
+    /** The Container's world tint when the texture was rendered, which is baked into its colors. */
+    Color color;
+    /** Draws the texture over its area, transformed by the Container's world affine. */
+    Drawable quad;
+    /** The world version of the Container @ref quad was placed with. */
+    uint32_t placedVersion = 0;
+    /** Whether the Container's subtree changed since the texture was rendered. */
+    bool dirty = true;
+    /** Whether the texture holds the Container. If not, the Container is rendered normally. */
+    bool valid = false;
+    /** Set while the Container is being rendered into the texture. */
+    bool rendering = false;
+
+    /**
+     * Moves @ref quad to where the texture's area is drawn.
+     * @param world The Container's world affine
+     */
+    void place(const math::Affine& world);
+};
+
+/** What the @ref Renderer did during a frame, see @ref Renderer::getFrameStats(). */
+struct FrameStats {
+    /** Draw calls submitted, including batches, static geometry and texture caches. */
+    uint32_t drawCalls = 0;
+    /** Draw calls that were built from transient vertices or instances. */
+    uint32_t batches = 0;
+    /** Vertices written to transient buffers. */
+    uint32_t vertices = 0;
+    /** Indices written to transient buffers. */
+    uint32_t indices = 0;
+    /** Sprite instances written to transient buffers. */
+    uint32_t instances = 0;
+    /** Bytes copied into transient buffers. */
+    uint64_t transientBytes = 0;
+    /** Bytes uploaded to retained vertex buffers through @ref Renderer::updateDynamic(). */
+    uint64_t uploadBytes = 0;
+
+    /** Batches ended because all texture slots were taken. */
+    uint32_t textureBreaks = 0;
+    /** Batches ended by switching between textured, untextured and instanced drawables, or blend modes. */
+    uint32_t programBreaks = 0;
+    /** Batches ended because their vertices would no longer be addressable by 16-bit indices. */
+    uint32_t indexOverflowBreaks = 0;
+    /** Batches ended because the transient buffer they were written to was full. */
+    uint32_t bufferBreaks = 0;
+    /** Batches ended because a drawable was out of range of the batch's origin, with compact vertex formats. */
+    uint32_t rangeBreaks = 0;
+    /** Batches ended for any other reason: at the end of the frame, or around static geometry, texture caches, cameras and render threads. */
+    uint32_t flushBreaks = 0;
+
+    /** CPU time of the last frame processed by bgfx, in milliseconds. */
+    double cpuFrameMs = 0;
+    /** GPU time of the last frame processed by bgfx, in milliseconds. 0 if the backend has no GPU timers. */
+    double gpuFrameMs = 0;
+};
+
 /**
  * The Renderer is an API which handles communication between the Application and bgfx.
  */
 class Renderer {
 public:
-    Renderer() = default;
-    virtual ~Renderer() = default;
+    /** The maximum number of textures a sprite batch can bind, if the backend supports enough samplers. */
+    static constexpr uint8_t MAX_TEXTURE_SLOTS = 16;
+
+    Renderer();
+    virtual ~Renderer();
 
     void init(Application& parentApp, const ApplicationConfig& config);
 
@@ -39,13 +188,177 @@ public:
 
     void resize(uint32_t width, uint32_t height);
 
+    /** The view the scene is rendered to. Views of texture caches are ordered before it. */
+    static constexpr bgfx::ViewId MAIN_VIEW = 0;
+
+    /**
+     * @return The area being rendered in world space. Containers whose bounds lie outside it are not rendered.
+     * This is the window while rendering the scene, and the cached area while rendering a @ref RenderCache.
+     */
+    [[nodiscard]] const math::Bounds& getViewBounds() const;
+
     void setBackgroundColor(const Color& color);
 
-    void queueDrawable(const Drawable& drawable);
+    /**
+     * Reserves space for a drawable in the current batch.
+     * Batches bind several textures at once, so the current batch is only submitted first if all its texture slots
+     * are taken, if switching between textured and untextured geometry, or if the vertices would not be addressable
+     * by the batch's index type.
+     * The span is written to the batch immediately. In deferred mode, everything queued before is sorted and drawn
+     * first, so the geometry keeps its scene order, but is never reordered with other drawables to save batches.
+     * @param texture The texture the vertices will be drawn with, or an invalid handle for untextured geometry
+     * @param numVertices The number of vertices to reserve
+     * @param numIndices The number of indices to reserve
+     * @param area The area covered by the vertices. Compact vertex formats start a new batch if it is out of range of
+     * the current batch's origin.
+     * @return The reserved memory. Indices written to it must be offset by @ref BatchSpan::baseVertex.
+     */
+    BatchSpan reserve(bgfx::TextureHandle texture, uint32_t numVertices, uint32_t numIndices, const math::Bounds& area);
+
+    /**
+     * Queues a drawable to be rendered this frame.
+     * In deferred mode, the drawable is only recorded, and must stay alive until the end of the frame.
+     * @param drawable The drawable
+     * @param order The draw order of the drawable, see @ref nextDrawOrder()
+     * @param blend How the drawable is blended
+     */
+    void queueDrawable(const Drawable& drawable, uint32_t order = 0, BlendMode blend = BlendMode::Alpha);
+
+    /**
+     * Takes the next number of this frame's draw order. Deferred mode sorts drawables by their draw order first,
+     * so drawables queued with increasing orders keep their scene order. Drawables sharing an order may be reordered
+     * by program and texture.
+     * @return The next draw order, or 0 outside of deferred mode
+     */
+    uint32_t nextDrawOrder() { return m_deferred ? ++m_drawOrder : 0; }
+
+    /**
+     * Queues a quad to be rendered this frame. Unlike @ref queueDrawable(), nothing is allocated or looped over per
+     * index, since all quads share the same index pattern.
+     * In deferred mode, the quad is only recorded, and must stay alive until the end of the frame.
+     * @param quad The quad
+     * @param order The draw order of the quad, see @ref nextDrawOrder()
+     * @param blend How the quad is blended
+     */
+    void queueQuad(const Quad& quad, uint32_t order = 0, BlendMode blend = BlendMode::Alpha);
+
+    /** @return Whether drawables are sorted before batching, see @ref ApplicationConfig::deferred. */
+    [[nodiscard]] bool isDeferred() const { return m_deferred; }
+
+    /**
+     * Enables or disables deferred mode.
+     * Must not be called while a frame is being rendered.
+     * @param deferred Whether drawables should be sorted before batching
+     */
+    void setDeferred(bool deferred) { m_deferred = deferred; }
+
+    /** @return Whether sprites are drawn through the instanced path, see @ref ApplicationConfig::instancedSprites. */
+    [[nodiscard]] bool isInstancing() const { return m_instancing; }
+
+    /**
+     * Queues one instance of the shared unit quad. Only available if @ref isInstancing() returns true.
+     * @param texture The texture to draw the instance with
+     * @param instance The instance data. Its texture slot is filled in by the renderer.
+     * @param order The draw order of the instance, see @ref nextDrawOrder()
+     */
+    void queueInstance(bgfx::TextureHandle texture, const SpriteInstance& instance, uint32_t order = 0);
 
+    /**
+     * Queues untextured geometry that lives in static GPU buffers, such as unchanging @ref Graphics.
+     * The geometry is drawn in its own draw call, and nothing is copied into transient buffers.
+     * @param vertices A vertex buffer created with @ref getVertexLayout()
+     * @param indices The index buffer
+     * @param numIndices The number of indices to draw
+     * @param order The draw order of the geometry, see @ref nextDrawOrder()
+     */
+    void queueStatic(bgfx::VertexBufferHandle vertices, bgfx::IndexBufferHandle indices, uint32_t numIndices, uint32_t order = 0);
+
+    /**
+     * Queues textured geometry stored in a dynamic vertex buffer, in the layout returned by @ref getVertexLayout().
+     * It is drawn in a single draw call of its own, with the textures bound to the slots its vertices refer to.
+     * In deferred mode, the textures must stay alive until the end of the frame.
+     * @param vertices The vertices
+     * @param indices The indices
+     * @param numIndices The number of indices to draw
+     * @param textures The textures, at most @ref getMaxTextureSlots()
+     * @param order The draw order of the geometry, see @ref nextDrawOrder()
+     */
+    void queueStatic(
+        bgfx::DynamicVertexBufferHandle vertices,
+        bgfx::IndexBufferHandle indices,
+        uint32_t numIndices,
+        std::span<const bgfx::TextureHandle> textures,
+        uint32_t order = 0
+    );
+
+    /**
+     * Uploads a range of vertices to a dynamic vertex buffer, counting it in @ref FrameStats::uploadBytes.
+     * @param vertices The buffer
+     * @param startVertex The first vertex to replace
+     * @param memory The new vertices
+     */
+    void updateDynamic(bgfx::DynamicVertexBufferHandle vertices, uint32_t startVertex, const bgfx::Memory* memory);
+
+    /**
+     * Applies a transform on the GPU to everything queued until the matching @ref popTransform(), on top of the
+     * current transform. The view bounds are mapped into the transformed space, so culling keeps working.
+     * @param affine The transform, from the space of the geometry queued next to the current space
+     */
+    void pushTransform(const math::Affine& affine);
+
+    /**
+     * Restores the transform and view bounds from before the last @ref pushTransform().
+     * @throws GmiException if no transform was pushed
+     */
+    void popTransform();
+
+    /**
+     * Registers a Container's texture cache. Dirty caches are re-rendered at the start of every frame.
+     * @param container The cached Container
+     * @param cache Its cache, which must outlive the registration
+     */
+    void addCache(Container& container, RenderCache& cache);
+
+    /**
+     * Unregisters a Container's texture cache and destroys its frame buffer.
+     * @param container The cached Container
+     */
+    void removeCache(Container& container);
+
+    /** @return The layout of @ref Vertex, for creating static vertex buffers. */
+    [[nodiscard]] const bgfx::VertexLayout& getVertexLayout() const { return m_vertexLayout; }
+
+    /** @return The format batched vertices are stored in, see @ref ApplicationConfig::vertexFormat. */
+    [[nodiscard]] VertexFormat getVertexFormat() const { return m_vertexFormat; }
+
+    /**
+     * Updates the transforms and bounds of a scene, then renders the parts of it that are in view.
+     * @param container The root of the scene
+     */
     void render(Container& container);
 
-    void shutdown() const;
+    /**
+     * Renders a Container's children on the render threads, see @ref ApplicationConfig::renderThreads.
+     * Only the first level of the scene with at least as many children as there are threads is split,
+     * in contiguous runs of children which are batched and submitted on their own thread.
+     * @param children The children to render
+     * @return Whether the children were rendered. If not, the caller must render them itself.
+     */
+    bool renderParallel(std::span<const ContainerPtr> children);
+
+    /** @return The number of threads the scene is rendered with, besides the main thread. */
+    [[nodiscard]] uint32_t getRenderThreads() const;
+
+    void shutdown();
+
+    /** @return Whether the renderer is initialized and GPU resources can be created or destroyed. */
+    [[nodiscard]] bool isInitialized() const { return m_initialized; }
+
+    /** @return The maximum number of textures a single batch can sample from. */
+    [[nodiscard]] uint8_t getMaxTextureSlots() const { return m_maxTextureSlots; }
+
+    /** @return Statistics of the previous frame. */
+    [[nodiscard]] const FrameStats& getFrameStats() const { return m_frameStats; }
 private:
     bool m_initialized = false;
     Application* m_parentApp = nullptr;
@@ -56,15 +369,186 @@ private:
     float m_projMatrix[16] = {};
     bgfx::ProgramHandle m_spriteProgram = BGFX_INVALID_HANDLE;
     bgfx::ProgramHandle m_colorProgram = BGFX_INVALID_HANDLE;
-    bgfx::UniformHandle m_sampler = BGFX_INVALID_HANDLE;
+    bgfx::ProgramHandle m_instancedProgram = BGFX_INVALID_HANDLE;
+    // static geometry is always stored in the float layout
+    bgfx::ProgramHandle m_staticProgram = BGFX_INVALID_HANDLE;
+    bgfx::ProgramHandle m_staticSpriteProgram = BGFX_INVALID_HANDLE;
+    bgfx::UniformHandle m_samplers[MAX_TEXTURE_SLOTS];
+    uint8_t m_maxTextureSlots = 8;
     bgfx::VertexLayout m_vertexLayout;
+    bool m_index32 = false;
+    uint32_t m_maxBatchVertices = UINT16_MAX + 1;
+
+    // Compact formats store textured and untextured vertices in separate streams, since their strides differ.
+    // Positions are relative to an origin set per batch through u_batchOrigin.
+    VertexFormat m_vertexFormat = VertexFormat::Float;
+    bgfx::VertexLayout m_streamLayouts[2];
+    bgfx::UniformHandle m_batchOriginUniform = BGFX_INVALID_HANDLE;
+
+    bool m_instancing = false;
+    bgfx::VertexLayout m_quadLayout;
+    bgfx::VertexBufferHandle m_quadVertices = BGFX_INVALID_HANDLE;
+    bgfx::IndexBufferHandle m_quadIndices = BGFX_INVALID_HANDLE;
 
     void reset() const;
 
-    std::vector<Vertex> m_batchVertices;
-    std::vector<uint16_t> m_batchIndices;
-    bgfx::TextureHandle m_batchTexture = BGFX_INVALID_HANDLE;
-    void submitBatch();
+    static constexpr uint32_t MIN_CHUNK_VERTICES = 4096;
+    static constexpr uint32_t MIN_CHUNK_INSTANCES = 1024;
+
+    enum class BatchProgram : uint8_t {
+        Color,
+        Sprite,
+        SpriteInstanced
+    };
+
+    /**
+     * The state of a batch being built on one thread.
+     * Batches are written into large transient buffers ("chunks") which are shared by consecutive batches.
+     * Each batch is then submitted as a sub-range of the current chunk.
+     */
+    struct BatchContext {
+        bgfx::Encoder* encoder = nullptr;
+        bgfx::ViewId view = MAIN_VIEW;
+        math::Bounds viewBounds;
+
+        struct VertexChunk {
+            bgfx::TransientVertexBuffer buffer{};
+            uint32_t capacity = 0, cursor = 0, batchFirst = 0;
+            uint32_t nextSize = MIN_CHUNK_VERTICES;
+            uint32_t written = 0;
+        };
+        VertexChunk vertexChunks[2];
+        bgfx::TransientIndexBuffer chunkIndices{};
+        uint32_t chunkIndexCapacity = 0, chunkIndexCursor = 0;
+        uint32_t nextChunkIndices = MIN_CHUNK_VERTICES / 2 * 3;
+
+        // instance data is chunked the same way
+        bgfx::InstanceDataBuffer chunkInstances{};
+        uint32_t chunkInstanceCapacity = 0, chunkInstanceCursor = 0;
+        uint32_t nextChunkInstances = MIN_CHUNK_INSTANCES;
+
+        BatchProgram batchProgram = BatchProgram::Color;
+        BlendMode batchBlend = BlendMode::Alpha;
+        uint32_t batchFirstIndex = 0, batchFirstInstance = 0;
+        // x, y: origin of compact positions, z: pixels per unit read by the shader, w: stored units per pixel
+        float batchOrigin[4] = {0, 0, 1, 1};
+
+        // GPU transforms pushed this frame. 0 is the identity, otherwise transform - 1 indexes transforms.
+        std::vector<math::Affine> transforms;
+        uint32_t transform = 0;
+        struct SavedTransform {
+            uint32_t transform;
+            math::Bounds viewBounds;
+        };
+        std::vector<SavedTransform> transformStack;
+        bgfx::TextureHandle batchTextures[MAX_TEXTURE_SLOTS];
+        uint8_t batchTextureCount = 0;
+
+        // Draw calls are ordered by depth, since submission order is lost across threads.
+        // Each run of the scene rendered on one thread gets its own segment: depth = segment (12) | sequence (20)
+        uint32_t depthSegment = 0, depthSequence = 0;
+
+        FrameStats stats;
+
+        /** Prepares the context for the next frame, keeping its chunk size estimates. */
+        void endFrame();
+    };
+
+    /** The context of the calling thread, or `nullptr` on the main thread. */
+    static thread_local BatchContext* s_context;
+    BatchContext m_mainContext;
+    std::vector<BatchContext> m_workerContexts;
+    std::unique_ptr<internal::WorkerPool> m_workers;
+    std::mutex m_transientMutex;
+    BatchContext& context() { return s_context != nullptr ? *s_context : m_mainContext; }
+
+    FrameStats m_frameStats;
+
+    enum class BatchBreak : uint8_t {
+        Texture,
+        Program,
+        IndexOverflow,
+        Buffer,
+        Range,
+        Flush
+    };
+
+    // Deferred mode: drawables are recorded with a sort key, radix sorted at the end of the frame, then batched.
+    // Key layout, from most to least significant bits:
+    //   draw order (32) | blend state (2) | program (2) | texture (16)
+    bool m_deferred = false;
+    uint32_t m_drawOrder = 0;
+    struct DrawItem {
+        uint64_t key;
+        uint32_t index;
+    };
+    struct DeferredInstance {
+        bgfx::TextureHandle texture;
+        SpriteInstance instance;
+        uint32_t transform;
+    };
+    std::vector<DrawItem> m_drawList, m_drawListScratch;
+    struct DeferredDrawable {
+        const Drawable* drawable;
+        BlendMode blend;
+        uint32_t transform;
+    };
+    std::vector<DeferredDrawable> m_deferredDrawables;
+    struct DeferredQuad {
+        const Quad* quad;
+        BlendMode blend;
+        uint32_t transform;
+    };
+    std::vector<DeferredQuad> m_deferredQuads;
+    std::vector<DeferredInstance> m_deferredInstances;
+    struct StaticDraw {
+        bgfx::VertexBufferHandle vertices;
+        bgfx::IndexBufferHandle indices;
+        uint32_t numIndices;
+        // set instead of vertices for textured geometry
+        bgfx::DynamicVertexBufferHandle dynamicVertices = BGFX_INVALID_HANDLE;
+        std::span<const bgfx::TextureHandle> textures;
+        uint32_t transform = 0;
+    };
+    std::vector<StaticDraw> m_deferredStatics;
+    static constexpr uint32_t INSTANCE_BIT = 1u << 31;
+    static constexpr uint32_t STATIC_BIT = 1u << 30;
+    static constexpr uint32_t QUAD_BIT = 1u << 29;
+    static constexpr uint32_t INDEX_MASK = QUAD_BIT - 1;
+
+    static uint64_t sortKey(uint32_t order, BlendMode blend, BatchProgram program, bgfx::TextureHandle texture);
+    void flushDrawList();
+
+    void emitDrawable(BatchContext& ctx, const Drawable& drawable, BlendMode blend);
+    void emitQuad(BatchContext& ctx, const Quad& quad, BlendMode blend);
+    void emitInstance(BatchContext& ctx, bgfx::TextureHandle texture, const SpriteInstance& instance);
+    void emitStatic(BatchContext& ctx, const StaticDraw& draw);
+    BatchSpan reserve(BatchContext& ctx, bgfx::TextureHandle texture, uint32_t numVertices, uint32_t numIndices, const math::Bounds& area, BlendMode blend);
+    [[nodiscard]] uint8_t streamOf(BatchProgram program) const;
+    bool fitsBatchOrigin(const BatchContext& ctx, const math::Bounds& area) const;
+    void setBatchOrigin(BatchContext& ctx, const math::Bounds& area) const;
+    void useProgram(BatchContext& ctx, BatchProgram program, BlendMode blend = BlendMode::Alpha);
+    uint8_t acquireTextureSlot(BatchContext& ctx, bgfx::TextureHandle texture);
+    bool allocVertexChunk(BatchContext& ctx, uint8_t stream, uint32_t numVertices);
+    bool allocIndexChunk(BatchContext& ctx, uint32_t numIndices);
+    bool allocInstanceChunk(BatchContext& ctx, uint32_t numInstances);
+    void submitBatch(BatchContext& ctx, BatchBreak reason = BatchBreak::Flush);
+    void useTransform(BatchContext& ctx, uint32_t transform);
+    static void setModelTransform(bgfx::Encoder* encoder, const BatchContext& ctx);
+    static uint32_t nextDepth(BatchContext& ctx);
+
+    // Texture caches are refreshed into their own views before the scene is rendered, deepest first
+    static constexpr uint16_t MAX_CACHE_VIEWS = 128;
+    struct CacheEntry {
+        Container* container;
+        RenderCache* cache;
+        uint32_t depth;
+    };
+    std::vector<CacheEntry> m_caches;
+    std::vector<bgfx::ViewId> m_viewOrder;
+    bool m_viewOrderChanged = false;
+    void refreshCaches();
+    bool refreshCache(Container& container, RenderCache& cache, bgfx::ViewId view);
 };
 
 }
@@ -12,14 +12,14 @@ public:
     void init();
 
     /**
-     * Loads a sound from disk.
+     * Loads a sound from disk. Does nothing if there is no audio device, such as in headless mode.
      * @param name The name of the sound
      * @param filePath The path to the sound
      */
     void load(const std::string& name, const std::string& filePath);
 
     /**
-     * Plays a sound.
+     * Plays a sound. Does nothing if there is no audio device, such as in headless mode.
      * @param name The name of the sound
      */
     void play(const std::string& name);
@@ -4,6 +4,8 @@
 
 namespace gmi {
 
+class SpriteBatch;
+
 class Sprite final : public Container {
 public:
     Sprite(Application* parentApp, Container* parent, const std::string& textureName, const math::Transform& transform = {});
@@ -14,9 +16,25 @@ public:
     [[nodiscard]] Texture& getTexture() const { return m_texture; }
 
     void render(Renderer& renderer) override;
+protected:
+    [[nodiscard]] math::Bounds getContentBounds() override { return m_quadBounds; }
 private:
-    Drawable m_drawable;
+    friend class SpriteBatch;
+
+    math::Bounds m_quadBounds;
+    /** The local and world versions the quad was last built from. */
+    uint32_t m_quadLocalVersion = UINT32_MAX;
+    uint32_t m_quadWorldVersion = UINT32_MAX;
+    Quad m_quad;
+    SpriteInstance m_instance{};
     Texture& m_texture;
+    // UV rect of the texture's frame, which does not change after loading
+    float m_u0 = 0, m_v0 = 0, m_u1 = 1, m_v1 = 1;
+
+    // set if the quad is drawn from a SpriteBatch's retained buffers instead
+    SpriteBatch* m_batch = nullptr;
+    uint32_t m_batchSlot = 0;
+    uint8_t m_batchTextureSlot = 0;
 };
 
 }
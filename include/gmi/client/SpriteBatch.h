@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "gmi/client/Container.h"
+
+namespace gmi {
+
+class Sprite;
+
+/**
+ * A Container which keeps the quads of its sprites in retained GPU buffers and draws them in a single draw call.
+ * Each sprite created through @ref createSprite() owns a stable slot in a dynamic vertex buffer, and only the slots of
+ * sprites that changed since the last frame are uploaded. Upload volume therefore scales with how much of the batch
+ * changed rather than with its size, which suits large, mostly static layers such as tile maps.
+ *
+ * Sprites of a batch are drawn in slot order regardless of their Z index, and are not culled individually.
+ * They can use at most @ref Renderer::getMaxTextureSlots() different textures, and their own children aren't rendered.
+ * Other children of the batch are rendered normally, after the batch.
+ */
+class SpriteBatch final : public Container {
+public:
+    SpriteBatch(Application* parentApp, Container* parent, const math::Transform& transform = {});
+    ~SpriteBatch() override;
+
+    /**
+     * Creates a sprite drawn by this batch.
+     * @param textureName The name of the sprite's texture
+     * @param transform The sprite's transform
+     * @return The sprite, which is a child of this batch
+     * @throws GmiException if the texture would exceed the number of textures a batch can use
+     */
+    Sprite& createSprite(const std::string& textureName, const math::Transform& transform = {});
+
+    /** @return The number of sprites drawn by this batch. */
+    [[nodiscard]] uint32_t getSpriteCount() const { return m_spriteCount; }
+protected:
+    void renderContent(Renderer& renderer) override;
+private:
+    friend class Sprite;
+
+    static constexpr uint32_t VERTICES_PER_SPRITE = 4;
+    static constexpr uint32_t INDICES_PER_SPRITE = 6;
+    static constexpr uint32_t MIN_CAPACITY = 64;
+    // dirty slots closer than this are uploaded together, trading a few redundant bytes for fewer updates
+    static constexpr uint32_t MERGE_GAP = 8;
+
+    // Slots of destroyed sprites are reused, and hold degenerate quads until then
+    std::vector<Sprite*> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    uint32_t m_spriteCount = 0;
+    /** One past the last occupied slot. */
+    uint32_t m_slotsInUse = 0;
+    std::vector<bgfx::TextureHandle> m_textures;
+
+    // CPU copy of the vertex buffer, and the slots which changed since the last upload
+    std::vector<Vertex> m_vertices;
+    std::vector<uint8_t> m_slotDirty;
+    std::vector<uint32_t> m_dirtySlots;
+
+    bgfx::DynamicVertexBufferHandle m_vertexBuffer = BGFX_INVALID_HANDLE;
+    bgfx::IndexBufferHandle m_indexBuffer = BGFX_INVALID_HANDLE;
+    /** The number of slots the GPU buffers were created for. */
+    uint32_t m_bufferCapacity = 0;
+
+    uint8_t acquireTextureSlot(bgfx::TextureHandle texture);
+    Vertex* slotVertices(uint32_t slot) { return &m_vertices[static_cast<size_t>(slot) * VERTICES_PER_SPRITE]; }
+    void markSlotDirty(uint32_t slot);
+    void releaseSlot(uint32_t slot);
+    void upload(Renderer& renderer);
+    void createBuffers(Renderer& renderer);
+    void destroyBuffers();
+};
+
+}
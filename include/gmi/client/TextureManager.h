@@ -8,8 +8,13 @@
 #include "bx/allocator.h"
 
 #include "gmi/math/Rect.h"
+#include "gmi/math/RectPacker.h"
 #include "gmi/math/Size.h"
 
+namespace bimg {
+struct ImageContainer;
+}
+
 namespace gmi {
 
 struct Texture {
@@ -20,6 +25,18 @@ struct Texture {
 
 class TextureManager {
 public:
+    /**
+     * Enables atlas mode. Images loaded from now on are packed into shared atlas pages instead of getting a texture
+     * each, so sprites using them can be drawn in the same batch.
+     * Images which don't fit in a page, or have mipmaps, still get their own texture.
+     * @param pageSize The width and height of atlas pages, clamped to the renderer's maximum texture size
+     * @param padding Texels around each image, filled by extending its edges so filtering never samples its neighbours
+     */
+    void enableAtlas(uint32_t pageSize = 2048, uint32_t padding = 1);
+
+    /** Disables atlas mode. Images already packed stay in their pages. */
+    void disableAtlas() { m_atlas = false; }
+
     /**
      * Loads a @ref Texture from disk.
      * @param name The name to give the texture
@@ -59,6 +76,18 @@ private:
     bx::DefaultAllocator m_allocator;
     std::vector<bgfx::TextureHandle> m_handles;
     std::unordered_map<std::string, Texture> m_textures;
+
+    struct AtlasPage {
+        bgfx::TextureHandle handle;
+        math::RectPacker packer;
+    };
+    bool m_atlas = false;
+    uint32_t m_atlasPageSize = 2048;
+    uint32_t m_atlasPadding = 1;
+    std::vector<AtlasPage> m_atlasPages;
+
+    /** @return Whether the image was packed into an atlas page and registered under the given name. */
+    bool addToAtlas(const std::string& name, const bimg::ImageContainer& image);
 };
 
 }
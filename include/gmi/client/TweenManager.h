@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "gmi/math/Easing.h"
@@ -11,34 +12,145 @@ namespace gmi {
 struct TweenVar {
     float* var;
     float endValue;
-    float startValue;
 };
 
 struct TweenOptions {
     std::vector<TweenVar> values;
     uint64_t duration;
+    /** The easing. Functions of @ref math::Easing are eased in batches, any other function once per tween. */
     math::EasingFn ease = math::Easing::linear;
     bool yoyo = false;
     bool infinite = false;
     std::function<void()> onUpdate = nullptr;
+    /** Called after an update that changed at least one of the tweened values, unlike @ref onUpdate. */
+    std::function<void()> onChange = nullptr;
     std::function<void()> onComplete = nullptr;
 };
 
-struct Tween {
-    TweenOptions opts;
-    uint64_t startTime;
-    uint64_t endTime;
+/**
+ * Identifies a tween of a @ref TweenManager. Handles pack a slot index and a generation, so the handle of a tween
+ * that finished or was killed never refers to a later tween reusing its slot. A default-constructed handle is invalid.
+ */
+struct TweenHandle {
+    uint32_t value = 0;
+
+    [[nodiscard]] bool isValid() const { return value != 0; }
+    bool operator==(const TweenHandle&) const = default;
 };
 
+/**
+ * Animates float values over time.
+ * Tweens are stored as parallel arrays in a dense slot map, and are advanced by a few linear passes over them every
+ * frame. Consecutive tweens with the same easing are eased as one batch. Callbacks are stored separately, only for
+ * tweens that have some.
+ */
 class TweenManager {
 public:
-    uint16_t add(const TweenOptions& opts);
-    bool kill(uint16_t id);
+    /** The maximum number of tweens that can be active at once. */
+    static constexpr uint32_t MAX_TWEENS = 1u << 22;
+
+    TweenManager();
+    ~TweenManager();
+
+    /**
+     * Starts a tween at the time of the last update.
+     * @param opts The tween's options
+     * @return The tween's handle, which stays valid until the tween completes or is killed
+     * @throws GmiException if the duration is zero or too many tweens are active
+     */
+    TweenHandle add(const TweenOptions& opts);
+
+    /**
+     * Stops a tween, leaving its values where they are.
+     * @param handle The tween's handle
+     * @return Whether the tween was still active
+     */
+    bool kill(TweenHandle handle);
+
+    /** @return Whether the tween is still active. */
+    [[nodiscard]] bool isActive(TweenHandle handle) const;
 
-    void update();
+    /** @return The number of active tweens. */
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(m_slots.size()) - m_deadCount; }
+
+    /**
+     * Allocates memory ahead of time.
+     * @param tweens The number of tweens
+     * @param values The total number of values tweened
+     */
+    void reserve(uint32_t tweens, uint32_t values);
+
+    /**
+     * Sets the error bound of easings evaluated from lookup tables. See @ref math::EasingTables.
+     * @param maxError The maximum absolute error, or 0 to always use the exact functions
+     */
+    void setEasingMaxError(float maxError) { m_easingTables.setMaxError(maxError); }
+
+    /**
+     * Advances all tweens. This method is called internally once per frame with the @ref Application's clock.
+     * @param now The current time in milliseconds
+     */
+    void update(uint64_t now);
 private:
-    std::unordered_map<uint16_t, Tween> m_tweens;
-    uint16_t m_nextId = 0;
+    static constexpr uint32_t INDEX_BITS = 22;
+    static constexpr uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static constexpr uint32_t MAX_GENERATION = (1u << (32 - INDEX_BITS)) - 1;
+
+    enum Flags : uint8_t {
+        Yoyo = 1 << 0,
+        Infinite = 1 << 1,
+        /** Runs from the end values to the start values, during the second half of a yoyo. */
+        Reversed = 1 << 2,
+        /** Reached its end during this update, and is retired once its callbacks ran. */
+        Finished = 1 << 3,
+        /** Killed or retired, and removed from the arrays on the next update. */
+        Dead = 1 << 4,
+    };
+
+    /** Marks tweens whose easing isn't one of @ref math::Easing, and is looked up in the custom easings. */
+    static constexpr math::EasingId CUSTOM_EASING = math::EasingId::Count;
+
+    struct Callbacks;
+    struct CustomEasing {
+        uint32_t tween;
+        math::EasingFn fn;
+    };
+
+    uint64_t m_now = 0;
+    math::EasingTables m_easingTables;
+
+    // Slot map from handles to tweens, indexed by slot
+    std::vector<uint32_t> m_slotTweens;
+    std::vector<uint16_t> m_slotGenerations;
+    std::vector<uint32_t> m_freeSlots;
+
+    // Tween data, indexed by tween
+    std::vector<uint64_t> m_startTimes;
+    std::vector<uint64_t> m_durations;
+    std::vector<float> m_invDurations;
+    std::vector<math::EasingId> m_easings;
+    std::vector<uint8_t> m_flags;
+    std::vector<uint32_t> m_slots;
+    // Per-update scratch: the interpolation factor, and whether any value changed
+    std::vector<float> m_weights;
+    std::vector<uint8_t> m_changed;
+    uint32_t m_deadCount = 0;
+
+    // Tweened values, indexed by value, with the index of the tween they belong to
+    std::vector<float*> m_targets;
+    std::vector<float> m_startValues;
+    std::vector<float> m_endValues;
+    std::vector<uint32_t> m_valueTweens;
+
+    /** Callbacks of the tweens that have some, in tween order. Boxed so they stay put while they run. */
+    std::vector<std::unique_ptr<Callbacks>> m_callbacks;
+    /** Easings of the tweens that use a custom function. */
+    std::vector<CustomEasing> m_customEasings;
+    std::vector<uint32_t> m_completed;
+    std::vector<uint32_t> m_remap;
+
+    void retire(uint32_t tween);
+    void compact();
 };
 
 }
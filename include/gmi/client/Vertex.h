@@ -1,13 +1,54 @@
 #pragma once
 
+#include <cstdint>
+
 #include "gmi/client/Color.h"
 
 namespace gmi {
 
+/** How batched vertices are stored in transient buffers, see @ref ApplicationConfig::vertexFormat. */
+enum class VertexFormat : uint8_t {
+    /** The layout of @ref Vertex: 24 bytes per vertex. */
+    Float,
+    /** Half-float positions relative to the batch origin: 16 bytes per textured and 8 per untextured vertex. */
+    Half,
+    /** 16-bit fixed point positions relative to the batch origin: 16 bytes per textured and 8 per untextured vertex. */
+    Int16
+};
+
 struct Vertex {
     float x, y;
     float u, v;
     Color color;
+    /** Index of the texture sampled by this vertex among the textures bound to its batch. Set by the @ref Renderer. */
+    float textureSlot = 0;
+};
+
+/**
+ * Per-instance data of a sprite drawn through the instanced path.
+ * The shared unit quad is mapped to the sprite's corners by the affine (a, b, c, d, x, y), so no vertices are
+ * expanded on the CPU. Every field is a float since bgfx instance data is read as vec4s.
+ */
+struct SpriteInstance {
+    float a, b, c, d;
+    float x, y;
+    /** UV of the quad's (0, 0) corner. */
+    float u0, v0;
+    /** UV of the quad's (1, 1) corner. */
+    float u1, v1;
+    /** The tint's red, green, and blue components packed as a 24-bit integer. */
+    float rgb;
+    /** The tint's alpha component multiplied by 16, plus the texture slot (filled in by the @ref Renderer). */
+    float alphaSlot;
+
+    /**
+     * Packs a tint into the rgb and alphaSlot fields.
+     * @param color The tint
+     */
+    void setColor(Color color) {
+        rgb = static_cast<float>(color.r << 16 | color.g << 8 | color.b);
+        alphaSlot = static_cast<float>(color.a * 16);
+    }
 };
 
 }
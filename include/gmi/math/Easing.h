@@ -1,6 +1,11 @@
 #pragma once
 #include "gmi/math/math.h"
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
 
 namespace gmi::math {
 
@@ -139,4 +144,148 @@ constexpr float backInOut(const float t) {
 }
 }
 
+/** Identifies one of the functions of @ref Easing, so easings can be stored compactly and evaluated in batches. */
+enum class EasingId : uint8_t {
+    Linear,
+    SineIn,
+    SineOut,
+    SineInOut,
+    CircIn,
+    CircOut,
+    CircInOut,
+    ElasticIn,
+    ElasticOut,
+    ElasticInOut,
+    ElasticOut2,
+    ExpoIn,
+    ExpoOut,
+    ExpoInOut,
+    QuadraticIn,
+    QuadraticOut,
+    QuadraticInOut,
+    CubicIn,
+    CubicOut,
+    CubicInOut,
+    QuarticIn,
+    QuarticOut,
+    QuarticInOut,
+    QuinticIn,
+    QuinticOut,
+    QuinticInOut,
+    SexticIn,
+    SexticOut,
+    SexticInOut,
+    BackIn,
+    BackOut,
+    BackInOut,
+    Count
+};
+
+/** The functions of @ref Easing, indexed by @ref EasingId. */
+inline constexpr EasingFn EASING_FUNCTIONS[static_cast<size_t>(EasingId::Count)] = {
+    Easing::linear,
+    Easing::sineIn,
+    Easing::sineOut,
+    Easing::sineInOut,
+    Easing::circIn,
+    Easing::circOut,
+    Easing::circInOut,
+    Easing::elasticIn,
+    Easing::elasticOut,
+    Easing::elasticInOut,
+    Easing::elasticOut2,
+    Easing::expoIn,
+    Easing::expoOut,
+    Easing::expoInOut,
+    Easing::quadraticIn,
+    Easing::quadraticOut,
+    Easing::quadraticInOut,
+    Easing::cubicIn,
+    Easing::cubicOut,
+    Easing::cubicInOut,
+    Easing::quarticIn,
+    Easing::quarticOut,
+    Easing::quarticInOut,
+    Easing::quinticIn,
+    Easing::quinticOut,
+    Easing::quinticInOut,
+    Easing::sexticIn,
+    Easing::sexticOut,
+    Easing::sexticInOut,
+    Easing::backIn,
+    Easing::backOut,
+    Easing::backInOut,
+};
+
+/** @return The function identified by the given ID. */
+constexpr EasingFn getEasingFn(EasingId id) {
+    return EASING_FUNCTIONS[static_cast<size_t>(id)];
+}
+
+/** @return The ID of one of the functions of @ref Easing, or `std::nullopt` for any other function. */
+constexpr std::optional<EasingId> getEasingId(EasingFn fn) {
+    for (size_t i = 0; i < static_cast<size_t>(EasingId::Count); i++) {
+        if (EASING_FUNCTIONS[i] == fn) {
+            return static_cast<EasingId>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * Evaluates an easing for many values at once. Polynomial easings are expanded into multiplications the compiler
+ * can vectorize, the others call their function for every value.
+ * @param id The easing
+ * @param t The values to ease, from 0 to 1
+ * @param out Where to write the eased values, at least as long as t. May be the same memory as t.
+ */
+void ease(EasingId id, std::span<const float> t, std::span<float> out);
+
+/**
+ * Evaluates easings in batches, replacing the easings that need trigonometric or exponential functions with linearly
+ * interpolated lookup tables. Tables are built on first use, doubling their resolution until the error measured
+ * halfway between samples is within the bound.
+ */
+class EasingTables {
+public:
+    /** The maximum number of intervals of a table, which bounds its memory to 256 KiB. */
+    static constexpr uint32_t MAX_INTERVALS = 1u << 16;
+
+    /** @param maxError The maximum absolute error of the tables, or 0 to always use the exact functions */
+    explicit EasingTables(float maxError = 1e-4f);
+
+    /**
+     * Evaluates an easing for many values at once, like @ref math::ease().
+     * Values out of the 0-1 range are clamped if the easing uses a table.
+     */
+    void ease(EasingId id, std::span<const float> t, std::span<float> out);
+
+    /** @return Whether an easing is evaluated from a table. */
+    [[nodiscard]] bool usesTable(EasingId id) const;
+
+    /**
+     * Changes the error bound, discarding the tables built so far.
+     * @param maxError The maximum absolute error of the tables, or 0 to always use the exact functions
+     */
+    void setMaxError(float maxError);
+
+    [[nodiscard]] float getMaxError() const { return m_maxError; }
+private:
+    struct Table {
+        /**
+         * Samples at evenly spaced points from 0 to 1. The first and last ones are extrapolated from their
+         * neighbors, because some easings jump at 0 or 1.
+         */
+        std::vector<float> samples;
+        /** The exact values at 0 and 1. */
+        float start, end;
+    };
+
+    float m_maxError;
+    /** The table of each easing, empty until first used. */
+    Table m_tables[static_cast<size_t>(EasingId::Count)];
+
+    const Table& getTable(EasingId id);
+};
+
 }
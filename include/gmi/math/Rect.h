@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <limits>
+
 namespace gmi::math {
 
 struct Rect {
@@ -11,4 +14,37 @@ struct UintRect {
     uint32_t x, y, w, h;
 };
 
+/** An axis-aligned bounding box. A default-constructed Bounds is empty. */
+struct Bounds {
+    float minX = std::numeric_limits<float>::infinity();
+    float minY = std::numeric_limits<float>::infinity();
+    float maxX = -std::numeric_limits<float>::infinity();
+    float maxY = -std::numeric_limits<float>::infinity();
+
+    /** @return Whether the bounds contain no points. */
+    [[nodiscard]] bool empty() const { return minX > maxX || minY > maxY; }
+
+    /** Grows the bounds to contain a point. */
+    void extend(float x, float y) {
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+
+    /** Grows the bounds to contain other bounds. */
+    void extend(const Bounds& other) {
+        minX = std::min(minX, other.minX);
+        minY = std::min(minY, other.minY);
+        maxX = std::max(maxX, other.maxX);
+        maxY = std::max(maxY, other.maxY);
+    }
+
+    /** @return Whether the bounds overlap. Empty bounds never overlap anything. */
+    [[nodiscard]] bool intersects(const Bounds& other) const {
+        return minX <= other.maxX && other.minX <= maxX
+            && minY <= other.maxY && other.minY <= maxY;
+    }
+};
+
 }
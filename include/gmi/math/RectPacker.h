@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmi/math/Rect.h"
+
+namespace gmi::math {
+
+/**
+ * Packs rectangles into a fixed-size area with the skyline bottom-left heuristic.
+ * The packer tracks the top edge ("skyline") of everything placed so far, and places each rectangle where its
+ * top edge ends up lowest. Rectangles are never moved or removed once placed.
+ */
+class RectPacker {
+public:
+    /**
+     * @param width The width of the area to pack into
+     * @param height The height of the area to pack into
+     */
+    RectPacker(uint32_t width, uint32_t height);
+
+    /**
+     * Places a rectangle.
+     * @param w The width of the rectangle
+     * @param h The height of the rectangle
+     * @return The placed rectangle, or `std::nullopt` if it doesn't fit anywhere. Empty rectangles take no space.
+     */
+    std::optional<UintRect> insert(uint32_t w, uint32_t h);
+
+    /** Removes every placed rectangle. */
+    void clear();
+
+    [[nodiscard]] uint32_t width() const { return m_width; }
+
+    [[nodiscard]] uint32_t height() const { return m_height; }
+
+    /** @return The total area of the placed rectangles. */
+    [[nodiscard]] uint64_t usedArea() const { return m_usedArea; }
+private:
+    /** A horizontal segment of the skyline, starting at x and covering w. Segments are sorted and contiguous. */
+    struct Segment {
+        uint32_t x, y, w;
+    };
+
+    uint32_t m_width, m_height;
+    uint64_t m_usedArea = 0;
+    std::vector<Segment> m_skyline;
+
+    /** @return The y a rectangle of width w would be placed at, starting at segment i, if it fits. */
+    [[nodiscard]] std::optional<uint32_t> fit(size_t i, uint32_t w, uint32_t h) const;
+};
+
+}
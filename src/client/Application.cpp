@@ -45,22 +45,38 @@ void Application::init(const ApplicationConfig& config) {
         throw GmiException("Application has already been initialized");
     }
 
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
+    m_headless = config.headless;
+    m_headlessFrames = config.headlessFrames;
+    m_headlessDt = config.headlessDt;
+    m_headlessSize = {config.width, config.height};
+
+    if (!SDL_Init(m_headless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         throw GmiException(std::string{"Unable to initialize SDL: "} + SDL_GetError());
     }
 
-    SDL_WindowFlags flags = 0;
-    if (config.resizable) {
-        flags |= SDL_WINDOW_RESIZABLE;
-    }
-    m_window = SDL_CreateWindow(config.title.c_str(), config.width, config.height, flags);
-    if (m_window == nullptr) {
-        throw GmiException(std::string{"Unable to create window: "} + SDL_GetError());
+    if (!m_headless) {
+        SDL_WindowFlags flags = 0;
+        if (config.resizable) {
+            flags |= SDL_WINDOW_RESIZABLE;
+        }
+        m_window = SDL_CreateWindow(config.title.c_str(), config.width, config.height, flags);
+        if (m_window == nullptr) {
+            throw GmiException(std::string{"Unable to create window: "} + SDL_GetError());
+        }
     }
 
     m_renderer.init(*this, config);
+    if (config.textureAtlas) {
+        m_textureManager.enableAtlas(config.atlasPageSize);
+    }
+    m_tweenManager.setEasingMaxError(config.easingMaxError);
+
+    if (!m_headless) {
+        m_soundManager.init();
+    }
 
-    m_soundManager.init();
+    m_time = m_headless ? 0 : nowMs();
+    m_tweenManager.update(m_time);
 
     m_initialized = true;
 }
@@ -70,16 +86,26 @@ void Application::onTick(const std::function<void()>& ticker) {
 }
 
 math::Size Application::getSize() const {
+    if (m_headless) {
+        return m_headlessSize;
+    }
+
     math::Size size;
     SDL_GetWindowSize(m_window, &size.width, &size.height);
     return size;
 }
 
-void Application::setSize(math::Size size) const {
-    SDL_SetWindowSize(m_window, size.width, size.height);
+void Application::setSize(math::Size size) {
+    setSize(size.width, size.height);
 }
 
-void Application::setSize(int width, int height) const {
+void Application::setSize(int width, int height) {
+    if (m_headless) {
+        // there's no window to send a resize event
+        m_headlessSize = {width, height};
+        m_renderer.resize(width, height);
+        return;
+    }
     SDL_SetWindowSize(m_window, width, height);
 }
 
@@ -104,17 +130,30 @@ SDL_AppResult Application::processEvent(SDL_Event* event) {
 
 SDL_AppResult Application::iterate() {
     time_point<steady_clock> frameStart = steady_clock::now();
-    if (!m_firstRun) {
-        m_dt = duration<float, std::milli>(steady_clock::now() - m_lastFrame).count();
+    if (m_headless) {
+        // accumulated in double precision, so fractional frame durations don't drift
+        m_dt = m_headlessDt;
+        m_headlessTime += m_headlessDt;
+        m_time = static_cast<uint64_t>(m_headlessTime);
     } else {
-        m_firstRun = false;
+        if (!m_firstRun) {
+            m_dt = duration<float, std::milli>(steady_clock::now() - m_lastFrame).count();
+        } else {
+            m_firstRun = false;
+        }
+        m_lastFrame = frameStart;
+        m_time = nowMs();
     }
-    m_lastFrame = frameStart;
 
     for (const auto& ticker : m_tickers)
         ticker();
-    m_tweenManager.update();
+    m_tweenManager.update(m_time);
     m_renderer.render(m_stage);
+    m_frameCount++;
+
+    if (m_headless) {
+        return m_headlessFrames > 0 && m_frameCount >= m_headlessFrames ? SDL_APP_SUCCESS : SDL_APP_CONTINUE;
+    }
 
     if (m_maxFps > 0) {
         float elapsed = duration<float, std::milli>(steady_clock::now() - frameStart).count();
@@ -127,7 +166,7 @@ SDL_AppResult Application::iterate() {
     return SDL_APP_CONTINUE;
 }
 
-void Application::shutdown(SDL_AppResult /*result*/) const {
+void Application::shutdown(SDL_AppResult /*result*/) {
     if (m_shutdownListener != nullptr) {
         m_shutdownListener();
     }
@@ -0,0 +1,41 @@
+#include "gmi/client/Camera.h"
+
+namespace gmi {
+
+Camera::Camera(Application* parentApp, Container* parent, const math::Transform& transform) :
+    Container(parentApp, parent, transform) { }
+
+void Camera::updateAffine() {
+    const math::Affine affine = math::Affine::fromTransform(m_transform);
+    if (m_parent != nullptr) {
+        m_viewAffine = m_parent->getAffine() * affine;
+        m_parentWorldVersion = m_parent->getWorldVersion();
+    } else {
+        m_viewAffine = affine;
+    }
+    m_transformDirty = false;
+    m_boundsDirty = true;
+    // the view moves the children within the camera's own space, so a texture cache of the camera is stale
+    m_subtreeDirty = true;
+
+    // children are laid out in the camera's space, so they only depend on its tint
+    if (m_worldVersion != 0 && m_viewAffine.color.rgbaHex() == m_affine.color.rgbaHex()) {
+        return;
+    }
+    m_affine = {};
+    m_affine.color = m_viewAffine.color;
+    m_worldVersion++;
+}
+
+void Camera::updateBounds() {
+    Container::updateBounds();
+    m_bounds = math::affineApplyBounds(m_viewAffine, m_bounds);
+}
+
+void Camera::renderContent(Renderer& renderer) {
+    renderer.pushTransform(m_viewAffine);
+    Container::renderContent(renderer);
+    renderer.popTransform();
+}
+
+}
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <ranges>
 
 #include "gmi/client/Affine.h"
 #include "gmi/client/Application.h"
@@ -7,69 +8,199 @@
 
 namespace gmi {
 
+Container::~Container() {
+    // the tweens write to this Container's transform
+    for (const TweenHandle handle : m_animations | std::views::values) {
+        m_parentApp->tweens().kill(handle);
+    }
+    if (m_cache != nullptr) {
+        m_parentApp->renderer().removeCache(*this);
+    }
+}
+
+void ContainerDeleter::operator()(Container* container) const {
+    if (container->m_pool != nullptr) {
+        container->m_pool->recycle(container);
+    } else {
+        delete container;
+    }
+}
+
+void Container::adoptChild(Container* child) {
+    child->m_childIndex = static_cast<uint32_t>(m_children.size());
+    // a new child has a Z index of 0, which may sort before the last child
+    if (!m_children.empty() && (m_children.back() == nullptr || m_children.back()->m_zIndex > 0)) {
+        m_childOrderDirty = true;
+    }
+    m_children.emplace_back(child);
+    markBoundsDirty();
+}
+
+NodePools& Container::nodePools() const {
+    return m_parentApp->nodePools();
+}
+
+void Container::release() {
+    if (m_parent != nullptr) {
+        m_parent->removeChild(this);
+    }
+}
+
 void Container::removeChild(Container* child) {
-    auto it = std::ranges::find_if(
-        m_children,
-        [child](const std::unique_ptr<Container>& m_child) {
-            return m_child.get() == child;
-        }
-    );
-    if (it != m_children.end()) {
-        m_children.erase(it);
-        child->m_parent = nullptr;
+    if (child == nullptr || child->m_parent != this) {
+        return;
+    }
+    const uint32_t index = child->m_childIndex;
+    if (index >= m_children.size() || m_children[index].get() != child) {
+        return;
+    }
+    // the slot is left as a tombstone, so later children keep their indices until the next compaction
+    m_children[index].reset();
+    m_removedChildren++;
+    markBoundsDirty();
+}
+
+void Container::removeChildren(std::span<Container* const> children) {
+    for (Container* child : children) {
+        removeChild(child);
     }
 }
 
 void Container::sortChildren() {
-    std::ranges::sort(
-        m_children,
-        [](const std::unique_ptr<Container>& a, const std::unique_ptr<Container>& b) {
-            return a->m_zIndex < b->m_zIndex;
+    m_childOrderDirty = true;
+    compactChildren();
+}
+
+void Container::compactChildren() const {
+    if (m_removedChildren == 0 && !m_childOrderDirty) {
+        return;
+    }
+
+    if (m_removedChildren > 0) {
+        std::erase(m_children, nullptr);
+        m_removedChildren = 0;
+    }
+
+    // Z indices rarely change, so the children are nearly sorted and an insertion sort is close to linear.
+    // It is also stable, so children with the same Z index stay in insertion order.
+    if (m_childOrderDirty) {
+        for (size_t i = 1; i < m_children.size(); i++) {
+            if (m_children[i]->m_zIndex >= m_children[i - 1]->m_zIndex) {
+                continue;
+            }
+            ContainerPtr child = std::move(m_children[i]);
+            size_t j = i;
+            for (; j > 0 && m_children[j - 1]->m_zIndex > child->m_zIndex; j--) {
+                m_children[j] = std::move(m_children[j - 1]);
+            }
+            m_children[j] = std::move(child);
         }
-    );
+        m_childOrderDirty = false;
+    }
+
+    for (uint32_t i = 0; i < m_children.size(); i++) {
+        m_children[i]->m_childIndex = i;
+    }
+}
+
+void Container::setZIndex(int zIndex) {
+    if (zIndex == m_zIndex) {
+        return;
+    }
+    m_zIndex = zIndex;
+    if (m_parent != nullptr) {
+        // the draw order changes, so the parent is revisited to re-sort it, and caches above it are redrawn
+        m_parent->m_childOrderDirty = true;
+        m_parent->markBoundsDirty();
+    }
 }
 
 void Container::setPosition(math::Vec2f position) {
     m_transform.position = position;
-    m_transformDirty = true;
+    markTransformDirty();
 }
 
 void Container::setRotation(float rotation) {
     m_transform.rotation = rotation;
-    m_transformDirty = true;
+    markTransformDirty();
 }
 
 void Container::setScale(math::Vec2f scale) {
     m_transform.scale = scale;
-    m_transformDirty = true;
+    markTransformDirty();
 }
 
 void Container::setScale(float scale) {
     m_transform.scale = {scale, scale};
-    m_transformDirty = true;
+    markTransformDirty();
 }
 
 void Container::setTint(Color tint) {
     m_transform.color = tint;
-    m_transformDirty = true;
+    markTransformDirty();
 }
 
 void Container::setPivot(math::Vec2f pivot) {
     m_transform.pivot = pivot;
+    markTransformDirty();
+}
+
+void Container::setVisible(bool visible) {
+    if (visible != m_visible) {
+        m_visible = visible;
+        markTransformDirty();
+    }
+}
+
+void Container::setCacheAsTexture(bool cache) {
+    if (cache == (m_cache != nullptr)) {
+        return;
+    }
+
+    if (cache) {
+        m_cache = std::make_unique<RenderCache>();
+        m_parentApp->renderer().addCache(*this, *m_cache);
+    } else {
+        m_parentApp->renderer().removeCache(*this);
+        m_cache.reset();
+    }
+}
+
+void Container::markTransformDirty() {
     m_transformDirty = true;
+    m_localVersion++;
+    // moving this Container changes what its ancestors contain, but not its own subtree, which moves as a whole
+    markDirty(m_parent);
+}
+
+void Container::markBoundsDirty() {
+    markDirty(this);
+}
+
+void Container::markDirty(Container* changed) {
+    // ancestors of a dirty Container are always dirty, so the walks stop at the first dirty one
+    for (Container* container = this; container != nullptr && !container->m_boundsDirty; container = container->m_parent) {
+        container->m_boundsDirty = true;
+    }
+    for (Container* container = changed; container != nullptr && !container->m_subtreeDirty; container = container->m_parent) {
+        container->m_subtreeDirty = true;
+    }
 }
 
 void Container::updateAffine() {
-    const math::Affine affine = math::Affine::fromTransform(m_transform);
+    math::Affine affine = math::Affine::fromTransform(m_transform);
     if (m_parent != nullptr) {
-        m_affine = m_parent->m_affine * affine;
-    } else {
-        m_affine = affine;
+        affine = m_parent->m_affine * affine;
+        m_parentWorldVersion = m_parent->m_worldVersion;
     }
+    m_transformDirty = false;
 
-    for (const auto& child : m_children) {
-        child->updateAffine();
+    if (m_worldVersion != 0 && affine == m_affine && affine.color.rgbaHex() == m_affine.color.rgbaHex()) {
+        return;
     }
+    m_affine = affine;
+    m_worldVersion++;
+    m_boundsDirty = true;
 }
 
 void Container::animate(const AnimateOptions<math::Vec2f>& opts) {
@@ -87,15 +218,13 @@ void Container::animate(const AnimateOptions<math::Vec2f>& opts) {
     default:
         throw GmiException("Attempted to animate a non-Vec2f property to a Vec2f target");
     }
-    uint16_t tweenId = m_parentApp->tweens().add({
+    addAnim(opts.prop, {
         .values = {{&prop->x, opts.target.x}, {&prop->y, opts.target.y}},
         .duration = opts.duration,
         .ease = opts.easing,
         .yoyo = opts.yoyo,
         .infinite = opts.infinite,
-        .onComplete = [this, &tweenId] { removeAnim(tweenId); },
     });
-    m_animations.emplace(opts.prop, tweenId);
 }
 
 void Container::animate(const AnimateOptions<float>& opts) {
@@ -107,36 +236,109 @@ void Container::animate(const AnimateOptions<float>& opts) {
     default:
         throw GmiException("Attempted to animate a non-float property to a float target");
     }
-    uint16_t tweenId = m_parentApp->tweens().add({
+    addAnim(opts.prop, {
         .values = {{prop, opts.target}},
         .duration = opts.duration,
         .ease = opts.easing,
         .yoyo = opts.yoyo,
         .infinite = opts.infinite,
-        .onComplete = [this, &tweenId] { removeAnim(tweenId); },
     });
-    m_animations.emplace(opts.prop, tweenId);
+}
+
+void Container::addAnim(math::TransformProps prop, TweenOptions opts) {
+    // a property is animated by one tween at a time, so the previous one can't overwrite the new one
+    stopAnimate(prop);
+    opts.onChange = [this] { markTransformDirty(); };
+    opts.onComplete = [this, prop] { m_animations.erase(prop); };
+    m_animations.emplace(prop, m_parentApp->tweens().add(opts));
 }
 
 void Container::stopAnimate(math::TransformProps prop) {
-    uint16_t id = m_animations[prop];
-    m_parentApp->tweens().kill(id);
-    removeAnim(id);
+    const auto iter = m_animations.find(prop);
+    if (iter == m_animations.end()) {
+        return;
+    }
+    m_parentApp->tweens().kill(iter->second);
+    m_animations.erase(iter);
+}
+
+void Container::updateTransforms() {
+    if (isAffineStale()) {
+        updateAffine();
+    }
+
+    // children of a moved Container are reached through its dirty bounds
+    if (!m_boundsDirty) {
+        return;
+    }
+    // the cache is in local space, so it only goes stale if the subtree changed or the tint baked into it did
+    if (m_cache != nullptr && (m_subtreeDirty || m_affine.color.rgbaHex() != m_cache->color.rgbaHex())) {
+        m_cache->dirty = true;
+    }
+
+    // Hidden subtrees are pruned: descendants keep their dirty state until this Container is shown again,
+    // which marks its transform dirty and brings the traversal back here.
+    if (!isRendered()) {
+        m_bounds = {};
+        m_boundsDirty = m_subtreeDirty = false;
+        return;
+    }
+
+    compactChildren();
+    updateBounds();
+    m_boundsDirty = m_subtreeDirty = false;
 }
 
-void Container::removeAnim(uint16_t id) {
-    std::erase_if(m_animations, [id](const std::pair<math::TransformProps, uint16_t>& anim) { return anim.second == id; });
+void Container::updateBounds() {
+    m_bounds = getContentBounds();
+    for (const auto& child : m_children) {
+        child->updateTransforms();
+        m_bounds.extend(child->m_bounds);
+    }
 }
 
 void Container::render(Renderer& renderer) {
-    if (m_transformDirty || !m_animations.empty()) {
-        updateAffine();
-        m_transformDirty = false;
+    m_skipDraw = !isRendered() || !m_bounds.intersects(renderer.getViewBounds());
+    if (m_skipDraw) {
+        return;
+    }
+
+    if (m_cache != nullptr && m_cache->valid && !m_cache->rendering) {
+        if (m_cache->placedVersion != m_worldVersion) {
+            m_cache->place(m_affine);
+            m_cache->placedVersion = m_worldVersion;
+        }
+        renderer.queueDrawable(m_cache->quad, drawOrder(renderer), BlendMode::Premultiplied);
+        m_skipDraw = true;
+        return;
     }
 
+    m_runOrder = 0;
+    renderContent(renderer);
+}
+
+void Container::renderContent(Renderer& renderer) {
+    if (renderer.renderParallel(m_children)) {
+        return;
+    }
     for (const auto& child : m_children) {
-        child->render(renderer);
+        renderChild(renderer, *child);
+    }
+}
+
+void Container::renderChild(Renderer& renderer, Container& child) {
+    if (m_runOrder == 0 || child.m_zIndex != m_runZIndex) {
+        m_runOrder = renderer.nextDrawOrder();
+        m_runZIndex = child.m_zIndex;
+    }
+    child.render(renderer);
+}
+
+uint32_t Container::drawOrder(Renderer& renderer) const {
+    if (m_children.empty() && m_parent != nullptr && m_parent->m_runOrder != 0) {
+        return m_parent->m_runOrder;
     }
+    return renderer.nextDrawOrder();
 }
 
 }
@@ -0,0 +1,329 @@
+#include <algorithm>
+
+#include "gmi/client/Application.h"
+#include "gmi/client/FlatScene.h"
+#include "gmi/client/gmi.h"
+#include "quadKernel.h"
+
+namespace gmi {
+
+FlatScene::FlatScene(Application* parentApp, Container* parent, const math::Transform& transform) :
+    Container(parentApp, parent, transform),
+    m_quadInputs(std::make_unique<internal::QuadArrays>()) { }
+
+FlatScene::~FlatScene() = default;
+
+NodeHandle FlatScene::createNode(NodeHandle parent, const math::Transform& transform) {
+    return insertNode(parent, transform, nullptr);
+}
+
+NodeHandle FlatScene::createSprite(const std::string& textureName, NodeHandle parent, const math::Transform& transform) {
+    return insertNode(parent, transform, &m_parentApp->textures().get(textureName));
+}
+
+bool FlatScene::isValid(NodeHandle node) const {
+    return node.id < m_generations.size() && m_generations[node.id] == node.generation && m_idToIndex[node.id] != NO_PARENT;
+}
+
+uint32_t FlatScene::indexOf(NodeHandle node) const {
+    if (!isValid(node)) {
+        throw GmiException("Invalid FlatScene node handle");
+    }
+    return m_idToIndex[node.id];
+}
+
+NodeHandle FlatScene::insertNode(NodeHandle parent, const math::Transform& transform, const Texture* texture) {
+    // the node goes right after its parent's last descendant, which keeps every subtree contiguous
+    uint32_t parentIndex = NO_PARENT;
+    auto position = static_cast<uint32_t>(size());
+    if (parent.valid()) {
+        parentIndex = indexOf(parent);
+        position = parentIndex + m_subtreeSizes[parentIndex];
+    }
+
+    uint32_t id;
+    if (!m_freeIds.empty()) {
+        id = m_freeIds.back();
+        m_freeIds.pop_back();
+    } else {
+        id = static_cast<uint32_t>(m_idToIndex.size());
+        m_idToIndex.push_back(NO_PARENT);
+        m_generations.push_back(0);
+    }
+
+    const auto at = static_cast<std::ptrdiff_t>(position);
+    m_local.insert(m_local.begin() + at, transform);
+    m_world.insert(m_world.begin() + at, math::Affine{});
+    m_parents.insert(m_parents.begin() + at, parentIndex);
+    m_subtreeSizes.insert(m_subtreeSizes.begin() + at, 1);
+    m_flags.insert(m_flags.begin() + at, DIRTY | VISIBLE);
+    m_textures.insert(m_textures.begin() + at, texture);
+    m_ids.insert(m_ids.begin() + at, id);
+    m_dirtyCount++;
+    m_quadsStale = true;
+
+    // nodes after the insertion point moved up by one
+    const auto count = static_cast<uint32_t>(size());
+    for (uint32_t i = position + 1; i < count; i++) {
+        if (m_parents[i] != NO_PARENT && m_parents[i] >= position) {
+            m_parents[i]++;
+        }
+        m_idToIndex[m_ids[i]] = i;
+    }
+    m_idToIndex[id] = position;
+    for (uint32_t ancestor = parentIndex; ancestor != NO_PARENT; ancestor = m_parents[ancestor]) {
+        m_subtreeSizes[ancestor]++;
+    }
+
+    markBoundsDirty();
+    return {id, m_generations[id]};
+}
+
+void FlatScene::destroy(NodeHandle node) {
+    const uint32_t index = indexOf(node);
+    const uint32_t count = m_subtreeSizes[index];
+    for (uint32_t ancestor = m_parents[index]; ancestor != NO_PARENT; ancestor = m_parents[ancestor]) {
+        m_subtreeSizes[ancestor] -= count;
+    }
+
+    for (uint32_t i = index; i < index + count; i++) {
+        const uint32_t id = m_ids[i];
+        m_generations[id]++;
+        m_idToIndex[id] = NO_PARENT;
+        m_freeIds.push_back(id);
+        if (m_flags[i] & DIRTY) {
+            m_dirtyCount--;
+        }
+    }
+
+    const auto first = static_cast<std::ptrdiff_t>(index);
+    const auto last = static_cast<std::ptrdiff_t>(index + count);
+    m_local.erase(m_local.begin() + first, m_local.begin() + last);
+    m_world.erase(m_world.begin() + first, m_world.begin() + last);
+    m_parents.erase(m_parents.begin() + first, m_parents.begin() + last);
+    m_subtreeSizes.erase(m_subtreeSizes.begin() + first, m_subtreeSizes.begin() + last);
+    m_flags.erase(m_flags.begin() + first, m_flags.begin() + last);
+    m_textures.erase(m_textures.begin() + first, m_textures.begin() + last);
+    m_ids.erase(m_ids.begin() + first, m_ids.begin() + last);
+
+    // nodes after the removed subtree moved down
+    const auto remaining = static_cast<uint32_t>(size());
+    for (uint32_t i = index; i < remaining; i++) {
+        if (m_parents[i] != NO_PARENT && m_parents[i] >= index) {
+            m_parents[i] -= count;
+        }
+        m_idToIndex[m_ids[i]] = i;
+    }
+
+    // the removed sprites no longer have quads, and may have defined the bounds
+    m_quadsStale = true;
+    markBoundsDirty();
+}
+
+void FlatScene::markDirty(uint32_t index) {
+    if (!(m_flags[index] & DIRTY)) {
+        m_flags[index] |= DIRTY;
+        m_dirtyCount++;
+    }
+    markBoundsDirty();
+}
+
+void FlatScene::setPosition(NodeHandle node, math::Vec2f position) {
+    const uint32_t index = indexOf(node);
+    m_local[index].position = position;
+    markDirty(index);
+}
+
+void FlatScene::setRotation(NodeHandle node, float rotation) {
+    const uint32_t index = indexOf(node);
+    m_local[index].rotation = rotation;
+    markDirty(index);
+}
+
+void FlatScene::setScale(NodeHandle node, math::Vec2f scale) {
+    const uint32_t index = indexOf(node);
+    m_local[index].scale = scale;
+    markDirty(index);
+}
+
+void FlatScene::setTint(NodeHandle node, Color tint) {
+    const uint32_t index = indexOf(node);
+    m_local[index].color = tint;
+    markDirty(index);
+}
+
+void FlatScene::setPivot(NodeHandle node, math::Vec2f pivot) {
+    const uint32_t index = indexOf(node);
+    m_local[index].pivot = pivot;
+    markDirty(index);
+}
+
+void FlatScene::setVisible(NodeHandle node, bool visible) {
+    const uint32_t index = indexOf(node);
+    if (visible == ((m_flags[index] & VISIBLE) != 0)) {
+        return;
+    }
+    m_flags[index] ^= VISIBLE;
+    markDirty(index);
+}
+
+void FlatScene::updateAffine() {
+    const uint32_t worldVersion = m_worldVersion;
+    Container::updateAffine();
+    m_allDirty |= worldVersion != m_worldVersion;
+}
+
+void FlatScene::updateBounds() {
+    propagate();
+    Container::updateBounds();
+}
+
+void FlatScene::propagate() {
+    if (m_dirtyCount == 0 && !m_allDirty && !m_quadsStale) {
+        return;
+    }
+
+    // parents precede their descendants, so one pass in order sees every parent's final affine
+    const size_t count = size();
+    const bool allDirty = m_allDirty;
+    m_changed.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t parent = m_parents[i];
+        const bool parentChanged = parent == NO_PARENT ? m_allDirty : m_changed[parent] != 0;
+        uint8_t& flags = m_flags[i];
+        if (!parentChanged && !(flags & DIRTY)) {
+            m_changed[i] = 0;
+            continue;
+        }
+
+        m_world[i] = (parent == NO_PARENT ? m_affine : m_world[parent]) * math::Affine::fromTransform(m_local[i]);
+        const bool hidden = !(flags & VISIBLE) || (parent != NO_PARENT && (m_flags[parent] & HIDDEN));
+        // a sprite being shown or hidden changes which quads exist
+        if (m_textures[i] != nullptr && hidden != ((flags & HIDDEN) != 0)) {
+            m_quadsStale = true;
+        }
+        flags = static_cast<uint8_t>((flags & ~(DIRTY | HIDDEN)) | (hidden ? HIDDEN : 0));
+        m_changed[i] = 1;
+    }
+    m_dirtyCount = 0;
+    m_allDirty = false;
+
+    if (m_quadsStale || allDirty) {
+        rebuildQuads();
+        m_quadsStale = false;
+    } else {
+        updateChangedQuads();
+    }
+
+    m_contentBounds = {};
+    for (const Vertex& vertex : m_quads) {
+        m_contentBounds.extend(vertex.x, vertex.y);
+    }
+}
+
+void FlatScene::pushQuad(uint32_t index) {
+    const auto& [handle, textureSize, frame] = *m_textures[index];
+    const auto tw = static_cast<float>(textureSize.w);
+    const auto th = static_cast<float>(textureSize.h);
+    m_quadInputs->push(
+        m_world[index],
+        static_cast<float>(frame.w),
+        static_cast<float>(frame.h),
+        m_local[index].pivot,
+        static_cast<float>(frame.x) / tw,
+        static_cast<float>(frame.y) / th,
+        static_cast<float>(frame.x + frame.w) / tw,
+        static_cast<float>(frame.y + frame.h) / th
+    );
+}
+
+void FlatScene::rebuildQuads() {
+    // the quads of all visible sprites are generated at once, then reused by every render until they change
+    m_quadInputs->clear();
+    m_quadNodes.clear();
+    for (size_t i = 0, count = size(); i < count; i++) {
+        if (m_textures[i] == nullptr || (m_flags[i] & HIDDEN)) {
+            continue;
+        }
+        pushQuad(static_cast<uint32_t>(i));
+        m_quadNodes.push_back(static_cast<uint32_t>(i));
+    }
+    m_quads.resize(m_quadNodes.size() * 4);
+    internal::buildQuads(m_quadInputs->inputs(), m_quadNodes.size(), m_quads.data());
+}
+
+void FlatScene::updateChangedQuads() {
+    // the set of visible sprites is unchanged, so only the quads of changed nodes are generated and copied in place
+    m_quadInputs->clear();
+    m_changedQuads.clear();
+    for (size_t q = 0, count = m_quadNodes.size(); q < count; q++) {
+        const uint32_t node = m_quadNodes[q];
+        if (m_changed[node]) {
+            pushQuad(node);
+            m_changedQuads.push_back(static_cast<uint32_t>(q));
+        }
+    }
+    if (m_changedQuads.empty()) {
+        return;
+    }
+
+    m_changedVertices.resize(m_changedQuads.size() * 4);
+    internal::buildQuads(m_quadInputs->inputs(), m_changedQuads.size(), m_changedVertices.data());
+    for (size_t k = 0, count = m_changedQuads.size(); k < count; k++) {
+        std::copy_n(&m_changedVertices[k * 4], 4, &m_quads[static_cast<size_t>(m_changedQuads[k]) * 4]);
+    }
+}
+
+void FlatScene::renderContent(Renderer& renderer) {
+    const math::Bounds& view = renderer.getViewBounds();
+
+    // visible sprites are gathered in runs sharing a texture, each reserved from the renderer at once
+    bgfx::TextureHandle runTexture = BGFX_INVALID_HANDLE;
+    math::Bounds runArea;
+    m_runVertices.clear();
+    for (size_t q = 0, count = m_quadNodes.size(); q < count; q++) {
+        const Texture* texture = m_textures[m_quadNodes[q]];
+        const Vertex* quad = &m_quads[q * 4];
+        math::Bounds quadBounds;
+        for (uint32_t k = 0; k < 4; k++) {
+            quadBounds.extend(quad[k].x, quad[k].y);
+        }
+        if (!quadBounds.intersects(view)) {
+            continue;
+        }
+
+        if (texture->handle.idx != runTexture.idx || m_runVertices.size() == MAX_RUN_QUADS * 4) {
+            flushRun(renderer, runTexture, runArea);
+            runTexture = texture->handle;
+            runArea = {};
+        }
+        m_runVertices.insert(m_runVertices.end(), quad, quad + 4);
+        runArea.extend(quadBounds);
+    }
+    flushRun(renderer, runTexture, runArea);
+
+    Container::renderContent(renderer);
+}
+
+void FlatScene::flushRun(Renderer& renderer, bgfx::TextureHandle texture, const math::Bounds& area) {
+    if (m_runVertices.empty()) {
+        return;
+    }
+
+    const auto numVertices = static_cast<uint32_t>(m_runVertices.size());
+    const uint32_t numQuads = numVertices / 4;
+    const BatchSpan span = renderer.reserve(texture, numVertices, numQuads * 6, area);
+    if (span.vertices != nullptr) {
+        for (uint32_t i = 0; i < numVertices; i++) {
+            span.setVertex(i, m_runVertices[i]);
+        }
+        for (uint32_t q = 0; q < numQuads; q++) {
+            for (uint32_t k = 0; k < 6; k++) {
+                span.setIndex(q * 6 + k, q * 4 + QUAD_INDICES[k]);
+            }
+        }
+    }
+    m_runVertices.clear();
+}
+
+}
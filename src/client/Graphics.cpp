@@ -1,3 +1,4 @@
+#include "gmi/client/Application.h"
 #include "gmi/client/Graphics.h"
 #include "gmi/math/Shape.h"
 #include <mapbox/earcut.hpp>
@@ -144,9 +145,14 @@ void round(
     }
 }
 
+Graphics::~Graphics() {
+    destroyStatic();
+}
+
 Graphics& Graphics::clear() {
     m_drawable.vertices.clear();
     m_drawable.indices.clear();
+    markGeometryDirty();
     return *this;
 }
 
@@ -155,6 +161,7 @@ Graphics& Graphics::drawLine(std::vector<math::Vec2f> points, const StrokeStyle&
         return *this;
     }
 
+    markGeometryDirty();
     auto& [vertices, indices, _] = m_drawable;
 
     std::vector<math::Vec2f> verts;
@@ -425,6 +432,7 @@ Graphics& Graphics::drawLine(std::vector<math::Vec2f> points, const StrokeStyle&
 }
 
 Graphics& Graphics::fillRect(float x, float y, float w, float h, Color color) {
+    markGeometryDirty();
     auto& [vertices, indices, _] = m_drawable;
 
     size_t numVertices = vertices.size();
@@ -452,6 +460,7 @@ Graphics& Graphics::fillCircle(float x, float y, float r, Color color) {
 }
 
 Graphics& Graphics::fillEllipse(float x, float y, float rx, float ry, Color color) {
+    markGeometryDirty();
     auto& [vertices, indices, _] = m_drawable;
 
     // Choose a number of segments such that the maximum absolute deviation from the circle is approximately 0.029
@@ -477,12 +486,13 @@ Graphics& Graphics::fillEllipse(float x, float y, float rx, float ry, Color colo
 }
 
 Graphics& Graphics::fillPoly(const std::vector<math::Vec2f>& points, Color color) {
+    markGeometryDirty();
     auto& [vertices, indices, texture] = m_drawable;
 
-    std::vector<uint16_t> polyIndices = mapbox::earcut<uint16_t>(std::vector<std::vector<math::Vec2f>>{points});
+    std::vector<uint32_t> polyIndices = mapbox::earcut<uint32_t>(std::vector<std::vector<math::Vec2f>>{points});
     size_t numVertices = vertices.size();
     indices.reserve(indices.size() + polyIndices.size());
-    for (uint16_t index : polyIndices) {
+    for (uint32_t index : polyIndices) {
         indices.emplace_back(numVertices + index);
     }
 
@@ -514,10 +524,78 @@ Graphics& Graphics::fillShape(const collision::Shape& shape, Color color) {
     }
 }
 
+void Graphics::markGeometryDirty() {
+    m_version++;
+    markBoundsDirty();
+}
+
+math::Bounds Graphics::getContentBounds() {
+    // vertices are drawn as given, without this Graphics' transform
+    if (m_boundsVersion != m_version) {
+        m_vertexBounds = {};
+        for (const Vertex& vertex : m_drawable.vertices) {
+            m_vertexBounds.extend(vertex.x, vertex.y);
+        }
+        m_boundsVersion = m_version;
+    }
+    return m_vertexBounds;
+}
+
 void Graphics::render(Renderer& renderer) {
     Container::render(renderer);
 
-    renderer.queueDrawable(m_drawable);
+    if (m_skipDraw || m_drawable.vertices.empty()) {
+        return;
+    }
+
+    // geometry that changed since the last frame goes through transient buffers until it settles
+    if (m_version != m_renderedVersion) {
+        m_renderedVersion = m_version;
+        renderer.queueDrawable(m_drawable, drawOrder(renderer));
+        return;
+    }
+
+    if (m_version != m_uploadedVersion) {
+        uploadStatic(renderer);
+    }
+    renderer.queueStatic(m_staticVertices, m_staticIndices, m_drawable.indices.size(), drawOrder(renderer));
+}
+
+void Graphics::uploadStatic(Renderer& renderer) {
+    destroyStatic();
+
+    const auto& [vertices, indices, _] = m_drawable;
+    m_staticVertices = bgfx::createVertexBuffer(
+        bgfx::copy(vertices.data(), vertices.size() * sizeof(Vertex)),
+        renderer.getVertexLayout()
+    );
+
+    // 16-bit indices where possible, since they are half the size and supported everywhere
+    if (vertices.size() <= UINT16_MAX + 1) {
+        const bgfx::Memory* mem = bgfx::alloc(indices.size() * sizeof(uint16_t));
+        auto* out = reinterpret_cast<uint16_t*>(mem->data);
+        for (size_t i = 0, len = indices.size(); i < len; i++) {
+            out[i] = static_cast<uint16_t>(indices[i]);
+        }
+        m_staticIndices = bgfx::createIndexBuffer(mem);
+    } else {
+        m_staticIndices = bgfx::createIndexBuffer(
+            bgfx::copy(indices.data(), indices.size() * sizeof(uint32_t)),
+            BGFX_BUFFER_INDEX32
+        );
+    }
+
+    m_uploadedVersion = m_version;
+}
+
+void Graphics::destroyStatic() {
+    // the buffers are already gone if the renderer was shut down before the scene was destroyed
+    if (bgfx::isValid(m_staticVertices) && m_parentApp->renderer().isInitialized()) {
+        bgfx::destroy(m_staticVertices);
+        bgfx::destroy(m_staticIndices);
+    }
+    m_staticVertices = BGFX_INVALID_HANDLE;
+    m_staticIndices = BGFX_INVALID_HANDLE;
 }
 
 }
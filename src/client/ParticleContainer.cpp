@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+#include "gmi/client/ParticleContainer.h"
+#include "gmi/client/Application.h"
+#include "gmi/client/gmi.h"
+#include "quadKernel.h"
+
+namespace gmi {
+
+ParticleContainer::ParticleContainer(Application* parentApp, Container* parent, const std::string& textureName, const math::Transform& transform) :
+    Container(parentApp, parent, transform),
+    m_quadInputs(std::make_unique<internal::QuadArrays>()) {
+    addFrame(parentApp->textures().get(textureName));
+    updateMaxExtent();
+}
+
+ParticleContainer::ParticleContainer(
+    Application* parentApp,
+    Container* parent,
+    const std::vector<std::string>& frameNames,
+    const math::Transform& transform
+) :
+    Container(parentApp, parent, transform),
+    m_quadInputs(std::make_unique<internal::QuadArrays>()) {
+    if (frameNames.empty()) {
+        throw GmiException("A ParticleContainer needs at least one frame");
+    }
+    for (const std::string& name : frameNames) {
+        addFrame(parentApp->textures().get(name));
+    }
+    updateMaxExtent();
+}
+
+ParticleContainer::~ParticleContainer() = default;
+
+void ParticleContainer::addFrame(const Texture& texture) {
+    if (bgfx::isValid(m_texture) && texture.handle.idx != m_texture.idx) {
+        throw GmiException("The frames of a ParticleContainer must be stored in the same texture");
+    }
+    m_texture = texture.handle;
+
+    const auto& [handle, textureSize, frame] = texture;
+    const auto tw = static_cast<float>(textureSize.w);
+    const auto th = static_cast<float>(textureSize.h);
+    m_frameData.push_back({
+        .u0 = static_cast<float>(frame.x) / tw,
+        .v0 = static_cast<float>(frame.y) / th,
+        .u1 = static_cast<float>(frame.x + frame.w) / tw,
+        .v1 = static_cast<float>(frame.y + frame.h) / th,
+        .w = static_cast<float>(frame.w),
+        .h = static_cast<float>(frame.h),
+    });
+}
+
+void ParticleContainer::updateMaxExtent() {
+    const float px = std::max(m_pivot.x, 1.0f - m_pivot.x);
+    const float py = std::max(m_pivot.y, 1.0f - m_pivot.y);
+    m_maxExtent = 0;
+    for (const Frame& frame : m_frameData) {
+        m_maxExtent = std::max(m_maxExtent, std::hypot(px * frame.w, py * frame.h));
+    }
+}
+
+uint32_t ParticleContainer::add(const Particle& particle) {
+    if (particle.frame >= m_frameData.size()) {
+        throw GmiException(std::format("Particle frame {} does not exist, there are {} frames", particle.frame, m_frameData.size()));
+    }
+    m_positions.push_back(particle.position);
+    m_rotations.push_back(particle.rotation);
+    m_scales.push_back(particle.scale);
+    m_tints.push_back(particle.tint);
+    m_frames.push_back(particle.frame);
+    markBoundsDirty();
+    return size() - 1;
+}
+
+void ParticleContainer::remove(uint32_t index) {
+    const uint32_t last = size() - 1;
+    if (index > last) {
+        return;
+    }
+    m_positions[index] = m_positions[last];
+    m_rotations[index] = m_rotations[last];
+    m_scales[index] = m_scales[last];
+    m_tints[index] = m_tints[last];
+    m_frames[index] = m_frames[last];
+    m_positions.pop_back();
+    m_rotations.pop_back();
+    m_scales.pop_back();
+    m_tints.pop_back();
+    m_frames.pop_back();
+    markBoundsDirty();
+}
+
+void ParticleContainer::clear() {
+    m_positions.clear();
+    m_rotations.clear();
+    m_scales.clear();
+    m_tints.clear();
+    m_frames.clear();
+    markBoundsDirty();
+}
+
+void ParticleContainer::reserve(uint32_t capacity) {
+    m_positions.reserve(capacity);
+    m_rotations.reserve(capacity);
+    m_scales.reserve(capacity);
+    m_tints.reserve(capacity);
+    m_frames.reserve(capacity);
+}
+
+Particle ParticleContainer::get(uint32_t index) const {
+    return {
+        .position = m_positions[index],
+        .rotation = m_rotations[index],
+        .scale = m_scales[index],
+        .tint = m_tints[index],
+        .frame = m_frames[index],
+    };
+}
+
+void ParticleContainer::set(uint32_t index, const Particle& particle) {
+    if (particle.frame >= m_frameData.size()) {
+        throw GmiException(std::format("Particle frame {} does not exist, there are {} frames", particle.frame, m_frameData.size()));
+    }
+    m_positions[index] = particle.position;
+    m_rotations[index] = particle.rotation;
+    m_scales[index] = particle.scale;
+    m_tints[index] = particle.tint;
+    m_frames[index] = particle.frame;
+    markBoundsDirty();
+}
+
+void ParticleContainer::setParticlePivot(math::Vec2f pivot) {
+    m_pivot = pivot;
+    updateMaxExtent();
+    markBoundsDirty();
+}
+
+math::Bounds ParticleContainer::getContentBounds() {
+    // Conservative: every particle fits in a circle around its pivot, whose radius only depends on its scale.
+    // This avoids expanding every quad twice per frame.
+    math::Bounds local;
+    for (uint32_t i = 0, count = size(); i < count; i++) {
+        const math::Vec2f center = m_positions[i] + m_pivot;
+        const float radius = m_maxExtent * std::max(std::abs(m_scales[i].x), std::abs(m_scales[i].y));
+        local.extend(center.x - radius, center.y - radius);
+        local.extend(center.x + radius, center.y + radius);
+    }
+    return math::affineApplyBounds(m_affine, local);
+}
+
+void ParticleContainer::renderContent(Renderer& renderer) {
+    const uint32_t count = size();
+    if (count == 0) {
+        Container::renderContent(renderer);
+        return;
+    }
+
+    // the world affine of every particle, the same as a Sprite with this transform would have
+    const math::Affine& m = m_affine;
+    internal::QuadArrays& inputs = *m_quadInputs;
+    inputs.clear();
+    inputs.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const math::Transform local{
+            .position = m_positions[i],
+            .rotation = m_rotations[i],
+            .scale = m_scales[i],
+            .pivot = m_pivot,
+            .color = m_tints[i],
+        };
+        const math::Affine world = m * math::Affine::fromTransform(local);
+        const Frame& frame = m_frameData[m_frames[i]];
+        inputs.push(world, frame.w, frame.h, m_pivot, frame.u0, frame.v0, frame.u1, frame.v1);
+    }
+    const internal::QuadInputs all = inputs.inputs();
+
+    // in deferred mode, the first reserve() draws everything queued before, so the particles keep their scene order
+    for (uint32_t first = 0; first < count; first += MAX_RUN_QUADS) {
+        const uint32_t numQuads = std::min(count - first, MAX_RUN_QUADS);
+        const BatchSpan span = renderer.reserve(m_texture, numQuads * 4, numQuads * 6, m_bounds);
+        if (span.vertices == nullptr) {
+            break;
+        }
+
+        // float vertices are generated straight into the batch, compact ones are converted from a scratch buffer
+        if (span.format == VertexFormat::Float) {
+            internal::buildQuads(all.offset(first), numQuads, static_cast<Vertex*>(span.vertices), span.textureSlot);
+        } else {
+            m_vertices.resize(static_cast<size_t>(numQuads) * 4);
+            internal::buildQuads(all.offset(first), numQuads, m_vertices.data());
+            for (uint32_t v = 0; v < numQuads * 4; v++) {
+                span.setVertex(v, m_vertices[v]);
+            }
+        }
+        for (uint32_t q = 0; q < numQuads; q++) {
+            for (uint32_t k = 0; k < 6; k++) {
+                span.setIndex(q * 6 + k, q * 4 + QUAD_INDICES[k]);
+            }
+        }
+    }
+
+    Container::renderContent(renderer);
+}
+
+}
@@ -1,32 +1,119 @@
+#include <algorithm>
+#include <cmath>
 #include <cstring>
+#include <functional>
+#include <format>
 
 #include "bgfx/bgfx.h"
 #include "bgfx/embedded_shader.h"
 #include "bx/math.h"
 
 #include "gmi/client/Application.h"
+#include "gmi/client/Camera.h"
+#include "gmi/client/Container.h"
 #include "gmi/client/Renderer.h"
 #include "gmi/client/gmi.h"
 
+#include "WorkerPool.h"
+#include "radixSort.h"
 #include "shaders.h"
 
 namespace gmi {
 
-void Renderer::init(Application& parentApp, const ApplicationConfig& config) {
-    if (m_initialized) {
-        throw GmiException("Renderer has already been initialized");
+thread_local Renderer::BatchContext* Renderer::s_context = nullptr;
+
+static void addCounters(FrameStats& total, const FrameStats& stats) {
+    total.drawCalls += stats.drawCalls;
+    total.batches += stats.batches;
+    total.vertices += stats.vertices;
+    total.indices += stats.indices;
+    total.instances += stats.instances;
+    total.transientBytes += stats.transientBytes;
+    total.uploadBytes += stats.uploadBytes;
+    total.textureBreaks += stats.textureBreaks;
+    total.programBreaks += stats.programBreaks;
+    total.indexOverflowBreaks += stats.indexOverflowBreaks;
+    total.bufferBreaks += stats.bufferBreaks;
+    total.rangeBreaks += stats.rangeBreaks;
+    total.flushBreaks += stats.flushBreaks;
+}
+
+// large enough for about 174k sprites per frame, at four 24-byte vertices each
+static constexpr uint32_t TRANSIENT_VB_SIZE = 16 << 20;
+static constexpr uint32_t TRANSIENT_IB_SIZE = 8 << 20;
+
+// Compact vertices, see VertexFormat. Positions are either half floats or normalized 16-bit integers.
+struct CompactSpriteVertex {
+    uint16_t x, y;
+    int16_t u, v;
+    Color color;
+    // normalized, so it is read as a float by every backend; the shader scales it back by COMPACT_SLOT_SCALE
+    uint8_t slot[4];
+};
+struct CompactColorVertex {
+    uint16_t x, y;
+    Color color;
+};
+
+// must match the factor in vs_sprite_compact.sc
+static constexpr float COMPACT_SLOT_SCALE = 255.0f;
+
+// The fragment shader picks a slot by rounding, so a decoded compact slot has to land within half a slot of
+// the value the float layout would carry
+static consteval bool compactSlotsMatchFloatSlots() {
+    for (uint8_t slot = 0; slot < Renderer::MAX_TEXTURE_SLOTS; slot++) {
+        float decoded = static_cast<float>(slot) / COMPACT_SLOT_SCALE * COMPACT_SLOT_SCALE;
+        float floatSlot = static_cast<float>(slot);
+        if (decoded - floatSlot >= 0.5f || floatSlot - decoded >= 0.5f) {
+            return false;
+        }
     }
+    return true;
+}
+static_assert(compactSlotsMatchFloatSlots(), "compact texture slots must decode to the same slot as float vertices");
 
-    m_parentApp = &parentApp;
-    m_vsync = config.vsync;
-    m_antialiasing = config.antialiasing;
+// Int16 positions start at 1/8 pixel precision, covering 4096 pixels around the batch origin
+static constexpr float INT16_UNITS_PER_PIXEL = 8.0f;
+static constexpr float INT16_MAX_UNITS = 32767.0f;
+// half floats keep sub-pixel precision up to 1024 pixels from the batch origin
+static constexpr float HALF_RANGE = 1024.0f;
 
-    bgfx::Init init;
-    init.type = config.renderer;
-    init.resolution.width = config.width;
-    init.resolution.height = config.height;
-    init.resolution.reset = config.vsync ? BGFX_RESET_VSYNC : BGFX_RESET_NONE;
-    const SDL_PropertiesID props = SDL_GetWindowProperties(parentApp.getWindow());
+static uint16_t encodePosition(float units, VertexFormat format) {
+    if (format == VertexFormat::Half) {
+        return bx::halfFromFloat(units);
+    }
+    return static_cast<uint16_t>(static_cast<int16_t>(std::clamp(std::lround(units), -32767L, 32767L)));
+}
+
+static int16_t encodeTexCoord(float value) {
+    return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+void BatchSpan::setCompactVertex(uint32_t i, const Vertex& vertex) const {
+    uint16_t x = encodePosition((vertex.x - originX) * unitsPerPixel, format);
+    uint16_t y = encodePosition((vertex.y - originY) * unitsPerPixel, format);
+    if (textured) {
+        static_cast<CompactSpriteVertex*>(vertices)[i] = {
+            .x = x,
+            .y = y,
+            .u = encodeTexCoord(vertex.u),
+            .v = encodeTexCoord(vertex.v),
+            .color = vertex.color,
+            .slot = {static_cast<uint8_t>(textureSlot), 0, 0, 0},
+        };
+    } else {
+        static_cast<CompactColorVertex*>(vertices)[i] = {.x = x, .y = y, .color = vertex.color};
+    }
+}
+
+// Alpha is accumulated separately, so texture caches end up with correct, premultiplied colors
+static constexpr uint64_t DRAW_STATE_ALPHA = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A
+    | BGFX_STATE_BLEND_FUNC_SEPARATE(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA, BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+static constexpr uint64_t DRAW_STATE_PREMULTIPLIED = BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A
+    | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_ONE, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+
+static void setPlatformData(bgfx::Init& init, SDL_Window* window) {
+    const SDL_PropertiesID props = SDL_GetWindowProperties(window);
 #if defined(SDL_PLATFORM_WIN32)
     init.platformData.nwh = SDL_GetPointerProperty(props, SDL_PROP_WINDOW_WIN32_HWND_POINTER, nullptr);
 #elif defined(SDL_PLATFORM_MACOS)
@@ -48,6 +135,36 @@ void Renderer::init(Application& parentApp, const ApplicationConfig& config) {
 #elif defined(EMSCRIPTEN)
     init.platformData.nwh = reinterpret_cast<void*>("#canvas");
 #endif
+}
+
+Renderer::Renderer() = default;
+Renderer::~Renderer() = default;
+
+void Renderer::init(Application& parentApp, const ApplicationConfig& config) {
+    if (m_initialized) {
+        throw GmiException("Renderer has already been initialized");
+    }
+
+    m_parentApp = &parentApp;
+    m_vsync = config.vsync && !config.headless;
+    m_antialiasing = config.antialiasing;
+    m_deferred = config.deferred;
+
+    bgfx::Init init;
+    init.type = config.renderer;
+    init.resolution.width = config.width;
+    init.resolution.height = config.height;
+    init.resolution.reset = config.vsync ? BGFX_RESET_VSYNC : BGFX_RESET_NONE;
+    init.limits.transientVbSize = TRANSIENT_VB_SIZE;
+    init.limits.transientIbSize = TRANSIENT_IB_SIZE;
+    init.limits.maxEncoders = static_cast<uint16_t>(std::max<uint32_t>(init.limits.maxEncoders, config.renderThreads + 1));
+    if (config.headless) {
+        // nothing is presented, but the whole frame is still built and submitted
+        init.type = bgfx::RendererType::Noop;
+        init.resolution.reset = BGFX_RESET_NONE;
+    } else {
+        setPlatformData(init, parentApp.getWindow());
+    }
     bgfx::init(init);
 
     static constexpr bx::Vec3 eye{0.0f, 0.0f, -1.0f};
@@ -55,27 +172,118 @@ void Renderer::init(Application& parentApp, const ApplicationConfig& config) {
     bx::mtxLookAt(m_viewMatrix, eye, at);
     resize(config.width, config.height);
 
+    // draw calls are ordered by their depth, which preserves scene order across render threads
+    bgfx::setViewMode(MAIN_VIEW, bgfx::ViewMode::DepthAscending);
+    if (config.renderThreads > 0) {
+        m_workerContexts.resize(config.renderThreads);
+        m_workers = std::make_unique<internal::WorkerPool>(config.renderThreads);
+    }
+
     bgfx::RendererType::Enum actualRenderer = bgfx::getRendererType();
+    const bgfx::Caps* caps = bgfx::getCaps();
+
+    // bind 16 textures per batch where the backend allows it, otherwise 8, or a single one on very limited backends
+    const uint32_t maxSamplers = caps->limits.maxTextureSamplers;
+    m_maxTextureSlots = maxSamplers >= 16 ? 16 : maxSamplers >= 8 ? 8 : 1;
+    // the fragment shader must not declare more samplers than the backend has
+    const auto spriteFragmentShader = [&] {
+        switch (m_maxTextureSlots) {
+        case 16:
+            return bgfx::createEmbeddedShader(&internal::FS_SPRITE16, actualRenderer, "fs_sprite16");
+        case 8:
+            return bgfx::createEmbeddedShader(&internal::FS_SPRITE, actualRenderer, "fs_sprite");
+        default:
+            return bgfx::createEmbeddedShader(&internal::FS_SPRITE1, actualRenderer, "fs_sprite1");
+        }
+    };
+
+    m_vertexFormat = config.vertexFormat;
+    if (m_vertexFormat == VertexFormat::Half && (caps->supported & BGFX_CAPS_VERTEX_ATTRIB_HALF) == 0) {
+        m_vertexFormat = VertexFormat::Int16;
+    }
+    bool compact = m_vertexFormat != VertexFormat::Float;
+
     m_spriteProgram = bgfx::createProgram(
-        bgfx::createEmbeddedShader(&internal::VS_SPRITE, actualRenderer, "vs_sprite"),
-        bgfx::createEmbeddedShader(&internal::FS_SPRITE, actualRenderer, "fs_sprite"),
+        compact
+            ? bgfx::createEmbeddedShader(&internal::VS_SPRITE_COMPACT, actualRenderer, "vs_sprite_compact")
+            : bgfx::createEmbeddedShader(&internal::VS_SPRITE, actualRenderer, "vs_sprite"),
+        spriteFragmentShader(),
         true
     );
     m_colorProgram = bgfx::createProgram(
+        compact
+            ? bgfx::createEmbeddedShader(&internal::VS_COLOR_COMPACT, actualRenderer, "vs_color_compact")
+            : bgfx::createEmbeddedShader(&internal::VS_COLOR, actualRenderer, "vs_color"),
+        bgfx::createEmbeddedShader(&internal::FS_COLOR, actualRenderer, "fs_color"),
+        true
+    );
+    m_staticProgram = bgfx::createProgram(
         bgfx::createEmbeddedShader(&internal::VS_COLOR, actualRenderer, "vs_color"),
         bgfx::createEmbeddedShader(&internal::FS_COLOR, actualRenderer, "fs_color"),
         true
     );
+    m_staticSpriteProgram = bgfx::createProgram(
+        bgfx::createEmbeddedShader(&internal::VS_SPRITE, actualRenderer, "vs_sprite"),
+        spriteFragmentShader(),
+        true
+    );
+
+    // the instanced path shares the sprite fragment shader, falling back to vertices if instancing isn't supported
+    m_instancing = config.instancedSprites && (caps->supported & BGFX_CAPS_INSTANCING) != 0;
+    if (m_instancing) {
+        m_instancedProgram = bgfx::createProgram(
+            bgfx::createEmbeddedShader(&internal::VS_SPRITE_INSTANCED, actualRenderer, "vs_sprite_instanced"),
+            spriteFragmentShader(),
+            true
+        );
 
-    m_sampler = bgfx::createUniform("s_texColor", bgfx::UniformType::Sampler);
+        m_quadLayout
+            .begin()
+            .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
+            .end();
+
+        static constexpr float quadVertices[] = {0, 0, 1, 0, 1, 1, 0, 1};
+        static constexpr uint16_t quadIndices[] = {0, 1, 2, 0, 2, 3};
+        m_quadVertices = bgfx::createVertexBuffer(bgfx::makeRef(quadVertices, sizeof(quadVertices)), m_quadLayout);
+        m_quadIndices = bgfx::createIndexBuffer(bgfx::makeRef(quadIndices, sizeof(quadIndices)));
+    }
+
+    // 32-bit indices allow batches of (practically) any size, otherwise batches are split at the 16-bit limit
+    m_index32 = (caps->supported & BGFX_CAPS_INDEX32) != 0;
+    m_maxBatchVertices = m_index32 ? UINT32_MAX : UINT16_MAX + 1;
+
+    for (uint8_t i = 0; i < MAX_TEXTURE_SLOTS; i++) {
+        m_samplers[i] = bgfx::createUniform(std::format("s_tex{}", i).c_str(), bgfx::UniformType::Sampler);
+    }
 
     m_vertexLayout
         .begin()
         .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
         .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
         .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+        .add(bgfx::Attrib::TexCoord1, 1, bgfx::AttribType::Float)
         .end();
 
+    if (compact) {
+        bgfx::AttribType::Enum positionType = m_vertexFormat == VertexFormat::Half ? bgfx::AttribType::Half : bgfx::AttribType::Int16;
+        bool normalizedPosition = m_vertexFormat == VertexFormat::Int16;
+        m_streamLayouts[0]
+            .begin()
+            .add(bgfx::Attrib::Position, 2, positionType, normalizedPosition)
+            .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Int16, true)
+            .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+            .add(bgfx::Attrib::TexCoord1, 4, bgfx::AttribType::Uint8, true)
+            .end();
+        m_streamLayouts[1]
+            .begin()
+            .add(bgfx::Attrib::Position, 2, positionType, normalizedPosition)
+            .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+            .end();
+        m_batchOriginUniform = bgfx::createUniform("u_batchOrigin", bgfx::UniformType::Vec4);
+    } else {
+        m_streamLayouts[0] = m_streamLayouts[1] = m_vertexLayout;
+    }
+
     setBackgroundColor(config.backgroundColor);
 
     m_initialized = true;
@@ -93,6 +301,7 @@ void Renderer::setVsync(bool vsync) {
 void Renderer::resize(uint32_t width, uint32_t height) {
     m_width = width;
     m_height = height;
+    m_mainContext.viewBounds = {0, 0, static_cast<float>(width), static_cast<float>(height)};
 
     bx::mtxOrtho(
         m_projMatrix,
@@ -106,8 +315,8 @@ void Renderer::resize(uint32_t width, uint32_t height) {
         false
     );
 
-    bgfx::setViewTransform(0, m_viewMatrix, m_projMatrix);
-    bgfx::setViewRect(0, 0, 0, width, height);
+    bgfx::setViewTransform(MAIN_VIEW, m_viewMatrix, m_projMatrix);
+    bgfx::setViewRect(MAIN_VIEW, 0, 0, width, height);
 
     reset();
 }
@@ -141,73 +350,893 @@ void Renderer::reset() const {
 }
 
 void Renderer::setBackgroundColor(const Color& color) {
-    bgfx::setViewClear(0, BGFX_CLEAR_COLOR, color.rgbaHex());
+    bgfx::setViewClear(MAIN_VIEW, BGFX_CLEAR_COLOR, color.rgbaHex());
 }
 
-void Renderer::queueDrawable(const Drawable& drawable) {
+const math::Bounds& Renderer::getViewBounds() const {
+    return s_context != nullptr ? s_context->viewBounds : m_mainContext.viewBounds;
+}
+
+BatchSpan Renderer::reserve(bgfx::TextureHandle texture, uint32_t numVertices, uint32_t numIndices, const math::Bounds& area) {
+    // the span is written right away, so everything recorded before it has to be drawn first
+    if (m_deferred && !m_drawList.empty()) {
+        flushDrawList();
+    }
+    return reserve(context(), texture, numVertices, numIndices, area, BlendMode::Alpha);
+}
+
+BatchSpan Renderer::reserve(
+    BatchContext& ctx,
+    bgfx::TextureHandle texture,
+    uint32_t numVertices,
+    uint32_t numIndices,
+    const math::Bounds& area,
+    BlendMode blend
+) {
+    if (numVertices > m_maxBatchVertices) {
+        throw GmiException(std::format(
+            "Drawable has {} vertices, but the renderer only supports {} vertices per draw call",
+            numVertices,
+            m_maxBatchVertices
+        ));
+    }
+
+    // textured and untextured geometry use different programs
+    bool textured = bgfx::isValid(texture);
+    BatchProgram program = textured ? BatchProgram::Sprite : BatchProgram::Color;
+    useProgram(ctx, program, blend);
+
+    uint8_t stream = streamOf(program);
+    BatchContext::VertexChunk& chunk = ctx.vertexChunks[stream];
+
+    // start a new batch exactly where the index type would overflow
+    if (numVertices > m_maxBatchVertices - (chunk.cursor - chunk.batchFirst)) {
+        submitBatch(ctx, BatchBreak::IndexOverflow);
+    }
+
+    if (chunk.cursor + numVertices > chunk.capacity) {
+        submitBatch(ctx, BatchBreak::Buffer);
+        if (!allocVertexChunk(ctx, stream, numVertices)) {
+            return {};
+        }
+    }
+    if (ctx.chunkIndexCursor + numIndices > ctx.chunkIndexCapacity) {
+        submitBatch(ctx, BatchBreak::Buffer);
+        if (!allocIndexChunk(ctx, numIndices)) {
+            return {};
+        }
+    }
+
+    // compact positions are relative to an origin picked by the first drawable of the batch
+    if (m_vertexFormat != VertexFormat::Float) {
+        if (chunk.cursor != chunk.batchFirst && !fitsBatchOrigin(ctx, area)) {
+            submitBatch(ctx, BatchBreak::Range);
+        }
+        if (chunk.cursor == chunk.batchFirst) {
+            setBatchOrigin(ctx, area);
+        }
+    }
+
+    // done last, since the checks above may have submitted the batch and released its texture slots
+    uint8_t slot = textured ? acquireTextureSlot(ctx, texture) : 0;
+
+    uint16_t stride = m_streamLayouts[stream].getStride();
+    size_t indexSize = m_index32 ? sizeof(uint32_t) : sizeof(uint16_t);
+    BatchSpan span{
+        .vertices = chunk.buffer.data + static_cast<size_t>(chunk.cursor) * stride,
+        .indices = ctx.chunkIndices.data + static_cast<size_t>(ctx.chunkIndexCursor) * indexSize,
+        .baseVertex = chunk.cursor - chunk.batchFirst,
+        .index32 = m_index32,
+        .textureSlot = static_cast<float>(slot),
+        .format = m_vertexFormat,
+        .textured = textured,
+        .originX = ctx.batchOrigin[0],
+        .originY = ctx.batchOrigin[1],
+        .unitsPerPixel = ctx.batchOrigin[3],
+    };
+    chunk.cursor += numVertices;
+    chunk.written += numVertices;
+    ctx.chunkIndexCursor += numIndices;
+    ctx.stats.vertices += numVertices;
+    ctx.stats.indices += numIndices;
+    ctx.stats.transientBytes += static_cast<uint64_t>(numVertices) * stride + numIndices * indexSize;
+    return span;
+}
+
+uint8_t Renderer::streamOf(BatchProgram program) const {
+    return m_vertexFormat != VertexFormat::Float && program == BatchProgram::Color ? 1 : 0;
+}
+
+bool Renderer::fitsBatchOrigin(const BatchContext& ctx, const math::Bounds& area) const {
+    const float range = m_vertexFormat == VertexFormat::Half ? HALF_RANGE : INT16_MAX_UNITS / ctx.batchOrigin[3];
+    return area.minX - ctx.batchOrigin[0] >= -range
+        && area.maxX - ctx.batchOrigin[0] <= range
+        && area.minY - ctx.batchOrigin[1] >= -range
+        && area.maxY - ctx.batchOrigin[1] <= range;
+}
+
+void Renderer::setBatchOrigin(BatchContext& ctx, const math::Bounds& area) const {
+    ctx.batchOrigin[0] = std::round((area.minX + area.maxX) * 0.5f);
+    ctx.batchOrigin[1] = std::round((area.minY + area.maxY) * 0.5f);
+    if (m_vertexFormat == VertexFormat::Half) {
+        ctx.batchOrigin[2] = ctx.batchOrigin[3] = 1.0f;
+        return;
+    }
+
+    // drawables too large for the default precision trade it for range
+    float extent = std::max(area.maxX - area.minX, area.maxY - area.minY) * 0.5f + 1.0f;
+    float unitsPerPixel = INT16_UNITS_PER_PIXEL;
+    while (extent * unitsPerPixel > INT16_MAX_UNITS && unitsPerPixel > 1.0f / 1024.0f) {
+        unitsPerPixel *= 0.5f;
+    }
+    // normalized positions reach the shader divided by INT16_MAX_UNITS
+    ctx.batchOrigin[2] = INT16_MAX_UNITS / unitsPerPixel;
+    ctx.batchOrigin[3] = unitsPerPixel;
+}
+
+void Renderer::queueDrawable(const Drawable& drawable, uint32_t order, BlendMode blend) {
+    if (!m_deferred) {
+        emitDrawable(context(), drawable, blend);
+        return;
+    }
+    if (drawable.vertices.empty()) {
+        return;
+    }
+
+    bool textured = bgfx::isValid(drawable.texture);
+    m_drawList.push_back({
+        .key = sortKey(order, blend, textured ? BatchProgram::Sprite : BatchProgram::Color, drawable.texture),
+        .index = static_cast<uint32_t>(m_deferredDrawables.size()),
+    });
+    m_deferredDrawables.push_back({&drawable, blend, m_mainContext.transform});
+}
+
+void Renderer::queueQuad(const Quad& quad, uint32_t order, BlendMode blend) {
+    if (!m_deferred) {
+        emitQuad(context(), quad, blend);
+        return;
+    }
+
+    bool textured = bgfx::isValid(quad.texture);
+    m_drawList.push_back({
+        .key = sortKey(order, blend, textured ? BatchProgram::Sprite : BatchProgram::Color, quad.texture),
+        .index = static_cast<uint32_t>(m_deferredQuads.size()) | QUAD_BIT,
+    });
+    m_deferredQuads.push_back({&quad, blend, m_mainContext.transform});
+}
+
+void Renderer::queueInstance(bgfx::TextureHandle texture, const SpriteInstance& instance, uint32_t order) {
+    if (!m_deferred) {
+        emitInstance(context(), texture, instance);
+        return;
+    }
+
+    // instances are copied, since sprites only keep their latest instance data
+    m_drawList.push_back({
+        .key = sortKey(order, BlendMode::Alpha, BatchProgram::SpriteInstanced, texture),
+        .index = static_cast<uint32_t>(m_deferredInstances.size()) | INSTANCE_BIT,
+    });
+    m_deferredInstances.push_back({texture, instance, m_mainContext.transform});
+}
+
+void Renderer::queueStatic(bgfx::VertexBufferHandle vertices, bgfx::IndexBufferHandle indices, uint32_t numIndices, uint32_t order) {
+    const StaticDraw draw{
+        .vertices = vertices,
+        .indices = indices,
+        .numIndices = numIndices,
+        .transform = context().transform,
+    };
+    if (!m_deferred) {
+        emitStatic(context(), draw);
+        return;
+    }
+
+    m_drawList.push_back({
+        .key = sortKey(order, BlendMode::Alpha, BatchProgram::Color, BGFX_INVALID_HANDLE),
+        .index = static_cast<uint32_t>(m_deferredStatics.size()) | STATIC_BIT,
+    });
+    m_deferredStatics.push_back(draw);
+}
+
+void Renderer::queueStatic(
+    bgfx::DynamicVertexBufferHandle vertices,
+    bgfx::IndexBufferHandle indices,
+    uint32_t numIndices,
+    std::span<const bgfx::TextureHandle> textures,
+    uint32_t order
+) {
+    if (textures.size() > m_maxTextureSlots) {
+        throw GmiException(std::format(
+            "Static geometry uses {} textures, but the renderer only supports {} textures per draw call",
+            textures.size(),
+            m_maxTextureSlots
+        ));
+    }
+
+    const StaticDraw draw{
+        .vertices = BGFX_INVALID_HANDLE,
+        .indices = indices,
+        .numIndices = numIndices,
+        .dynamicVertices = vertices,
+        .textures = textures,
+        .transform = context().transform,
+    };
+    if (!m_deferred) {
+        emitStatic(context(), draw);
+        return;
+    }
+
+    bgfx::TextureHandle firstTexture = BGFX_INVALID_HANDLE;
+    if (!textures.empty()) {
+        firstTexture = textures[0];
+    }
+    m_drawList.push_back({
+        .key = sortKey(order, BlendMode::Alpha, BatchProgram::Sprite, firstTexture),
+        .index = static_cast<uint32_t>(m_deferredStatics.size()) | STATIC_BIT,
+    });
+    m_deferredStatics.push_back(draw);
+}
+
+void Renderer::updateDynamic(bgfx::DynamicVertexBufferHandle vertices, uint32_t startVertex, const bgfx::Memory* memory) {
+    context().stats.uploadBytes += memory->size;
+    bgfx::update(vertices, startVertex, memory);
+}
+
+uint64_t Renderer::sortKey(uint32_t order, BlendMode blend, BatchProgram program, bgfx::TextureHandle texture) {
+    return static_cast<uint64_t>(order) << 20
+        | static_cast<uint64_t>(blend) << 18
+        | static_cast<uint64_t>(program) << 16
+        | texture.idx;
+}
+
+void Renderer::flushDrawList() {
+    const uint32_t transform = m_mainContext.transform;
+    internal::radixSort(m_drawList, m_drawListScratch);
+    for (const DrawItem& item : m_drawList) {
+        if (item.index & INSTANCE_BIT) {
+            const DeferredInstance& deferred = m_deferredInstances[item.index & INDEX_MASK];
+            useTransform(m_mainContext, deferred.transform);
+            emitInstance(m_mainContext, deferred.texture, deferred.instance);
+        } else if (item.index & STATIC_BIT) {
+            const StaticDraw& deferred = m_deferredStatics[item.index & INDEX_MASK];
+            useTransform(m_mainContext, deferred.transform);
+            emitStatic(m_mainContext, deferred);
+        } else if (item.index & QUAD_BIT) {
+            const DeferredQuad& deferred = m_deferredQuads[item.index & INDEX_MASK];
+            useTransform(m_mainContext, deferred.transform);
+            emitQuad(m_mainContext, *deferred.quad, deferred.blend);
+        } else {
+            const DeferredDrawable& deferred = m_deferredDrawables[item.index];
+            useTransform(m_mainContext, deferred.transform);
+            emitDrawable(m_mainContext, *deferred.drawable, deferred.blend);
+        }
+    }
+    useTransform(m_mainContext, transform);
+    m_drawList.clear();
+    m_deferredDrawables.clear();
+    m_deferredQuads.clear();
+    m_deferredInstances.clear();
+    m_deferredStatics.clear();
+}
+
+void Renderer::emitDrawable(BatchContext& ctx, const Drawable& drawable, BlendMode blend) {
     const auto& [vertices, indices, texture] = drawable;
+    if (vertices.empty()) {
+        return;
+    }
 
-    if (texture.idx != m_batchTexture.idx) {
-        submitBatch();
-        m_batchTexture = texture;
+    math::Bounds area;
+    if (m_vertexFormat != VertexFormat::Float) {
+        for (const Vertex& vertex : vertices) {
+            area.extend(vertex.x, vertex.y);
+        }
     }
 
-    size_t numVertices = m_batchVertices.size();
-    for (uint16_t index : indices) {
-        m_batchIndices.push_back(numVertices + index);
+    const BatchSpan span = reserve(ctx, texture, vertices.size(), indices.size(), area, blend);
+    if (span.vertices == nullptr) {
+        return;
     }
 
-    m_batchVertices.insert(m_batchVertices.end(), vertices.begin(), vertices.end());
+    size_t numIndices = indices.size();
+    if (span.index32) {
+        auto* out = static_cast<uint32_t*>(span.indices);
+        for (size_t i = 0; i < numIndices; i++) {
+            out[i] = span.baseVertex + indices[i];
+        }
+    } else {
+        auto* out = static_cast<uint16_t*>(span.indices);
+        for (size_t i = 0; i < numIndices; i++) {
+            out[i] = static_cast<uint16_t>(span.baseVertex + indices[i]);
+        }
+    }
+    for (uint32_t i = 0, len = vertices.size(); i < len; i++) {
+        span.setVertex(i, vertices[i]);
+    }
 }
 
-void Renderer::submitBatch() {
-    if (m_batchVertices.empty())
+void Renderer::emitQuad(BatchContext& ctx, const Quad& quad, BlendMode blend) {
+    const Vertex* vertices = quad.vertices;
+
+    math::Bounds area;
+    if (m_vertexFormat != VertexFormat::Float) {
+        for (uint32_t i = 0; i < 4; i++) {
+            area.extend(vertices[i].x, vertices[i].y);
+        }
+    }
+
+    const BatchSpan span = reserve(ctx, quad.texture, 4, 6, area, blend);
+    if (span.vertices == nullptr) {
         return;
+    }
+
+    if (span.index32) {
+        auto* out = static_cast<uint32_t*>(span.indices);
+        for (uint32_t i = 0; i < 6; i++) {
+            out[i] = span.baseVertex + QUAD_INDICES[i];
+        }
+    } else {
+        auto* out = static_cast<uint16_t*>(span.indices);
+        const auto base = static_cast<uint16_t>(span.baseVertex);
+        for (uint32_t i = 0; i < 6; i++) {
+            out[i] = static_cast<uint16_t>(base + QUAD_INDICES[i]);
+        }
+    }
+    for (uint32_t i = 0; i < 4; i++) {
+        span.setVertex(i, vertices[i]);
+    }
+}
+
+void Renderer::emitInstance(BatchContext& ctx, bgfx::TextureHandle texture, const SpriteInstance& instance) {
+    useProgram(ctx, BatchProgram::SpriteInstanced);
+
+    if (ctx.chunkInstanceCursor == ctx.chunkInstanceCapacity) {
+        submitBatch(ctx, BatchBreak::Buffer);
+        if (!allocInstanceChunk(ctx, 1)) {
+            return;
+        }
+    }
 
-    static constexpr size_t VERT_SIZE = sizeof(Vertex);
-    static constexpr size_t IND_SIZE = sizeof(uint16_t);
+    uint8_t slot = acquireTextureSlot(ctx, texture);
 
-    bgfx::TransientVertexBuffer vertexBuffer{};
-    size_t numVertices = m_batchVertices.size();
-    bgfx::allocTransientVertexBuffer(&vertexBuffer, numVertices, m_vertexLayout);
-    std::memcpy(vertexBuffer.data, m_batchVertices.data(), numVertices * VERT_SIZE);
-    bgfx::setVertexBuffer(0, &vertexBuffer);
+    auto* out = reinterpret_cast<SpriteInstance*>(ctx.chunkInstances.data) + ctx.chunkInstanceCursor;
+    *out = instance;
+    out->alphaSlot += slot;
+    ctx.chunkInstanceCursor++;
+    ctx.stats.instances++;
+    ctx.stats.transientBytes += sizeof(SpriteInstance);
+}
+
+void Renderer::emitStatic(BatchContext& ctx, const StaticDraw& draw) {
+    // drawn on its own, after everything queued before it
+    submitBatch(ctx);
+
+    bgfx::Encoder* encoder = ctx.encoder;
+    encoder->setIndexBuffer(draw.indices, 0, draw.numIndices);
+    encoder->setState(DRAW_STATE_ALPHA);
+    setModelTransform(encoder, ctx);
+    if (draw.textures.empty()) {
+        encoder->setVertexBuffer(0, draw.vertices);
+        encoder->submit(ctx.view, m_staticProgram, nextDepth(ctx));
+    } else {
+        encoder->setVertexBuffer(0, draw.dynamicVertices);
+        for (uint8_t i = 0; i < m_maxTextureSlots; i++) {
+            encoder->setTexture(i, m_samplers[i], draw.textures[i < draw.textures.size() ? i : 0]);
+        }
+        encoder->submit(ctx.view, m_staticSpriteProgram, nextDepth(ctx));
+    }
+    ctx.stats.drawCalls++;
+}
+
+void Renderer::useProgram(BatchContext& ctx, BatchProgram program, BlendMode blend) {
+    if (program != ctx.batchProgram || blend != ctx.batchBlend) {
+        submitBatch(ctx, BatchBreak::Program);
+        ctx.batchProgram = program;
+        ctx.batchBlend = blend;
+    }
+}
 
-    bgfx::TransientIndexBuffer indexBuffer{};
-    size_t numIndices = m_batchIndices.size();
-    bgfx::allocTransientIndexBuffer(&indexBuffer, numIndices);
-    std::memcpy(indexBuffer.data, m_batchIndices.data(), numIndices * IND_SIZE);
-    bgfx::setIndexBuffer(&indexBuffer);
+uint8_t Renderer::acquireTextureSlot(BatchContext& ctx, bgfx::TextureHandle texture) {
+    uint8_t slot = 0;
+    while (slot < ctx.batchTextureCount && ctx.batchTextures[slot].idx != texture.idx) {
+        slot++;
+    }
+    if (slot == ctx.batchTextureCount) {
+        if (ctx.batchTextureCount == m_maxTextureSlots) {
+            submitBatch(ctx, BatchBreak::Texture);
+            slot = 0;
+        }
+        ctx.batchTextures[ctx.batchTextureCount++] = texture;
+    }
+    return slot;
+}
+
+bool Renderer::allocVertexChunk(BatchContext& ctx, uint8_t stream, uint32_t numVertices) {
+    // Chunks grow geometrically within a frame, and the first chunk of a frame is sized after the previous frame,
+    // so a scene whose size is stable only needs a single chunk per frame
+    BatchContext::VertexChunk& chunk = ctx.vertexChunks[stream];
+    uint32_t want = std::max(numVertices, chunk.nextSize);
+
+    // render threads share the transient buffers, so checking and allocating must not be interleaved
+    std::lock_guard lock(m_transientMutex);
+    uint32_t avail = bgfx::getAvailTransientVertexBuffer(want, m_streamLayouts[stream]);
+    if (avail < numVertices) {
+        // out of transient memory for this frame, the drawable is dropped
+        chunk.capacity = chunk.cursor = chunk.batchFirst = 0;
+        return false;
+    }
+
+    bgfx::allocTransientVertexBuffer(&chunk.buffer, avail, m_streamLayouts[stream]);
+    chunk.capacity = avail;
+    chunk.cursor = chunk.batchFirst = 0;
+    chunk.nextSize = avail * 2;
+    return true;
+}
+
+bool Renderer::allocIndexChunk(BatchContext& ctx, uint32_t numIndices) {
+    uint32_t want = std::max(numIndices, ctx.nextChunkIndices);
+
+    std::lock_guard lock(m_transientMutex);
+    uint32_t avail = bgfx::getAvailTransientIndexBuffer(want, m_index32);
+    if (avail < numIndices) {
+        ctx.chunkIndexCapacity = ctx.chunkIndexCursor = ctx.batchFirstIndex = 0;
+        return false;
+    }
+
+    bgfx::allocTransientIndexBuffer(&ctx.chunkIndices, avail, m_index32);
+    ctx.chunkIndexCapacity = avail;
+    ctx.chunkIndexCursor = ctx.batchFirstIndex = 0;
+    ctx.nextChunkIndices = avail * 2;
+    return true;
+}
+
+bool Renderer::allocInstanceChunk(BatchContext& ctx, uint32_t numInstances) {
+    static constexpr uint16_t STRIDE = sizeof(SpriteInstance);
+
+    uint32_t want = std::max(numInstances, ctx.nextChunkInstances);
+
+    std::lock_guard lock(m_transientMutex);
+    uint32_t avail = bgfx::getAvailInstanceDataBuffer(want, STRIDE);
+    if (avail < numInstances) {
+        ctx.chunkInstanceCapacity = ctx.chunkInstanceCursor = 0;
+        ctx.batchFirstInstance = 0;
+        return false;
+    }
+
+    bgfx::allocInstanceDataBuffer(&ctx.chunkInstances, avail, STRIDE);
+    ctx.chunkInstanceCapacity = avail;
+    ctx.chunkInstanceCursor = 0;
+    ctx.batchFirstInstance = 0;
+    ctx.nextChunkInstances = avail * 2;
+    return true;
+}
+
+void Renderer::pushTransform(const math::Affine& affine) {
+    BatchContext& ctx = context();
+    submitBatch(ctx);
+
+    ctx.transformStack.push_back({ctx.transform, ctx.viewBounds});
+    ctx.transforms.push_back(ctx.transform != 0 ? ctx.transforms[ctx.transform - 1] * affine : affine);
+    ctx.transform = static_cast<uint32_t>(ctx.transforms.size());
+    ctx.viewBounds = math::affineApplyInverseBounds(affine, ctx.viewBounds);
+}
+
+void Renderer::popTransform() {
+    BatchContext& ctx = context();
+    if (ctx.transformStack.empty()) {
+        throw GmiException("popTransform() called without a matching pushTransform()");
+    }
+    submitBatch(ctx);
+
+    const BatchContext::SavedTransform& saved = ctx.transformStack.back();
+    ctx.transform = saved.transform;
+    ctx.viewBounds = saved.viewBounds;
+    ctx.transformStack.pop_back();
+}
+
+void Renderer::useTransform(BatchContext& ctx, uint32_t transform) {
+    if (transform != ctx.transform) {
+        submitBatch(ctx);
+        ctx.transform = transform;
+    }
+}
+
+void Renderer::setModelTransform(bgfx::Encoder* encoder, const BatchContext& ctx) {
+    if (ctx.transform == 0) {
+        return;
+    }
+
+    // the affine's 3x3 matrix embedded in a 4x4 one, in bx's row-vector layout
+    const math::Affine& m = ctx.transforms[ctx.transform - 1];
+    const float mtx[16] = {
+        m.a, m.b, 0, 0,
+        m.c, m.d, 0, 0,
+        0,   0,   1, 0,
+        m.x, m.y, 0, 1,
+    };
+    encoder->setTransform(mtx);
+}
+
+uint32_t Renderer::nextDepth(BatchContext& ctx) {
+    return ctx.depthSegment << 20 | ctx.depthSequence++;
+}
+
+void Renderer::submitBatch(BatchContext& ctx, BatchBreak reason) {
+    bgfx::Encoder* encoder = ctx.encoder;
+    if (ctx.batchProgram == BatchProgram::SpriteInstanced) {
+        uint32_t numInstances = ctx.chunkInstanceCursor - ctx.batchFirstInstance;
+        if (numInstances == 0)
+            return;
+
+        encoder->setVertexBuffer(0, m_quadVertices);
+        encoder->setIndexBuffer(m_quadIndices);
+        encoder->setInstanceDataBuffer(&ctx.chunkInstances, ctx.batchFirstInstance, numInstances);
+        ctx.batchFirstInstance = ctx.chunkInstanceCursor;
+    } else {
+        BatchContext::VertexChunk& chunk = ctx.vertexChunks[streamOf(ctx.batchProgram)];
+        uint32_t numVertices = chunk.cursor - chunk.batchFirst;
+        uint32_t numIndices = ctx.chunkIndexCursor - ctx.batchFirstIndex;
+        if (numVertices == 0)
+            return;
+
+        // indices are relative to the first vertex of the batch, which is used as the base vertex
+        encoder->setVertexBuffer(0, &chunk.buffer, chunk.batchFirst, numVertices);
+        encoder->setIndexBuffer(&ctx.chunkIndices, ctx.batchFirstIndex, numIndices);
+        chunk.batchFirst = chunk.cursor;
+        ctx.batchFirstIndex = ctx.chunkIndexCursor;
+        if (m_vertexFormat != VertexFormat::Float) {
+            encoder->setUniform(m_batchOriginUniform, ctx.batchOrigin);
+        }
+    }
 
-    bgfx::setState(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_BLEND_ALPHA);
+    encoder->setState(ctx.batchBlend == BlendMode::Premultiplied ? DRAW_STATE_PREMULTIPLIED : DRAW_STATE_ALPHA);
+    setModelTransform(encoder, ctx);
 
-    if (bgfx::isValid(m_batchTexture)) {
-        bgfx::setTexture(0, m_sampler, m_batchTexture);
-        bgfx::submit(0, m_spriteProgram);
+    if (ctx.batchProgram == BatchProgram::Color) {
+        encoder->submit(ctx.view, m_colorProgram, nextDepth(ctx));
     } else {
-        bgfx::submit(0, m_colorProgram);
+        // unused slots get the first texture, so every sampler the program declares is bound
+        for (uint8_t i = 0; i < m_maxTextureSlots; i++) {
+            encoder->setTexture(i, m_samplers[i], ctx.batchTextures[i < ctx.batchTextureCount ? i : 0]);
+        }
+        encoder->submit(ctx.view, ctx.batchProgram == BatchProgram::Sprite ? m_spriteProgram : m_instancedProgram, nextDepth(ctx));
     }
 
-    m_batchVertices.clear();
-    m_batchIndices.clear();
-    m_batchTexture = BGFX_INVALID_HANDLE;
+    ctx.stats.drawCalls++;
+    ctx.stats.batches++;
+    switch (reason) {
+    case BatchBreak::Texture:
+        ctx.stats.textureBreaks++;
+        break;
+    case BatchBreak::Program:
+        ctx.stats.programBreaks++;
+        break;
+    case BatchBreak::IndexOverflow:
+        ctx.stats.indexOverflowBreaks++;
+        break;
+    case BatchBreak::Buffer:
+        ctx.stats.bufferBreaks++;
+        break;
+    case BatchBreak::Range:
+        ctx.stats.rangeBreaks++;
+        break;
+    case BatchBreak::Flush:
+        ctx.stats.flushBreaks++;
+        break;
+    }
+    ctx.batchTextureCount = 0;
+}
+
+bool Renderer::renderParallel(std::span<const ContainerPtr> children) {
+    // Only the main thread splits the scene, and deferred mode has to sort the whole frame on the main thread.
+    // Narrow levels are left to the caller, so a single root child doesn't leave every other thread idle.
+    if (m_workers == nullptr || s_context != nullptr || m_deferred || children.size() < m_workers->size()) {
+        return false;
+    }
+
+    // everything queued before the children is drawn first
+    submitBatch(m_mainContext);
+
+    // a few runs per thread, so threads that finish early can pick up more work
+    const size_t numChildren = children.size();
+    const auto numJobs = static_cast<uint32_t>(std::min<size_t>(numChildren, m_workers->size() * 4));
+    const uint32_t firstSegment = m_mainContext.depthSegment + 1;
+
+    m_workers->run(numJobs, [&](uint32_t job, uint32_t worker) {
+        BatchContext& ctx = m_workerContexts[worker];
+        ctx.view = m_mainContext.view;
+        ctx.viewBounds = m_mainContext.viewBounds;
+        ctx.transform = 0;
+        if (m_mainContext.transform != 0) {
+            ctx.transforms.push_back(m_mainContext.transforms[m_mainContext.transform - 1]);
+            ctx.transform = static_cast<uint32_t>(ctx.transforms.size());
+        }
+        ctx.encoder = bgfx::begin(true);
+        if (ctx.encoder == nullptr) {
+            throw GmiException("Unable to create a bgfx encoder for a render thread");
+        }
+        ctx.depthSegment = firstSegment + job;
+        ctx.depthSequence = 0;
+        s_context = &ctx;
+
+        try {
+            for (size_t i = numChildren * job / numJobs, last = numChildren * (job + 1) / numJobs; i < last; i++) {
+                children[i]->render(*this);
+            }
+            submitBatch(ctx);
+        } catch (...) {
+            s_context = nullptr;
+            bgfx::end(ctx.encoder);
+            throw;
+        }
+
+        s_context = nullptr;
+        bgfx::end(ctx.encoder);
+        ctx.encoder = nullptr;
+    });
+
+    // anything queued after the children is drawn last
+    m_mainContext.depthSegment = firstSegment + numJobs;
+    m_mainContext.depthSequence = 0;
+    return true;
+}
+
+uint32_t Renderer::getRenderThreads() const {
+    return m_workers != nullptr ? m_workers->size() : 0;
+}
+
+void Renderer::addCache(Container& container, RenderCache& cache) {
+    m_caches.push_back({&container, &cache, 0});
+}
+
+void Renderer::removeCache(Container& container) {
+    auto it = std::ranges::find(m_caches, &container, &CacheEntry::container);
+    if (it == m_caches.end()) {
+        return;
+    }
+
+    // the frame buffer is already gone if the renderer was shut down before the scene was destroyed
+    if (bgfx::isValid(it->cache->frameBuffer) && m_initialized) {
+        bgfx::destroy(it->cache->frameBuffer);
+    }
+    it->cache->frameBuffer = BGFX_INVALID_HANDLE;
+    it->cache->texture = BGFX_INVALID_HANDLE;
+    it->cache->valid = false;
+    m_caches.erase(it);
+}
+
+void Renderer::refreshCaches() {
+    bgfx::ViewId nextView = MAIN_VIEW + 1;
+    bool hadCacheViews = m_viewOrder.size() > 1;
+    m_viewOrder.clear();
+
+    // nested caches are refreshed first, so the caches containing them can draw them as a single quad
+    bool anyDirty = false;
+    for (CacheEntry& entry : m_caches) {
+        anyDirty |= entry.cache->dirty;
+        entry.depth = 0;
+        for (Container* parent = entry.container->getParent(); parent != nullptr; parent = parent->getParent()) {
+            entry.depth++;
+        }
+    }
+    if (anyDirty) {
+        std::ranges::sort(m_caches, std::greater{}, &CacheEntry::depth);
+        for (const CacheEntry& entry : m_caches) {
+            if (entry.cache->dirty && nextView < MAIN_VIEW + 1 + MAX_CACHE_VIEWS && refreshCache(*entry.container, *entry.cache, nextView)) {
+                m_viewOrder.push_back(nextView++);
+            }
+        }
+    }
+
+    if (!m_viewOrder.empty()) {
+        m_viewOrder.push_back(MAIN_VIEW);
+        bgfx::setViewOrder(0, static_cast<uint16_t>(m_viewOrder.size()), m_viewOrder.data());
+    } else if (hadCacheViews) {
+        bgfx::setViewOrder(); // back to the default order
+    }
+}
+
+bool Renderer::refreshCache(Container& container, RenderCache& cache, bgfx::ViewId view) {
+    // bounds inside cameras are in the camera's space, and stale inside hidden subtrees
+    if (!container.isRendered()) {
+        return false;
+    }
+    math::Bounds screenBounds = container.getBounds();
+    for (const Container* ancestor = container.getParent(); ancestor != nullptr; ancestor = ancestor->getParent()) {
+        if (!ancestor->isRendered()) {
+            return false; // refreshed once it is shown again
+        }
+        if (const auto* camera = dynamic_cast<const Camera*>(ancestor)) {
+            screenBounds = math::affineApplyBounds(camera->getViewAffine(), screenBounds);
+        }
+    }
+    if (!screenBounds.intersects(m_mainContext.viewBounds)) {
+        return false; // refreshed once it comes into view
+    }
+
+    // the subtree is rendered in the Container's local space, so moving it or its ancestors keeps the texture valid
+    const math::Affine& world = container.getAffine();
+    if (world.a * world.d - world.b * world.c == 0) {
+        cache.valid = false;
+        cache.dirty = false;
+        return false;
+    }
+    const math::Bounds bounds = math::affineApplyInverseBounds(world, container.getBounds());
+
+    // snapped to whole local units, so the cached texels line up with the screen when the Container isn't scaled
+    math::Bounds area{std::floor(bounds.minX), std::floor(bounds.minY), std::ceil(bounds.maxX), std::ceil(bounds.maxY)};
+    const float width = area.maxX - area.minX;
+    const float height = area.maxY - area.minY;
+    const auto maxSize = static_cast<float>(bgfx::getCaps()->limits.maxTextureSize);
+    if (width < 1 || height < 1 || width > maxSize || height > maxSize) {
+        cache.valid = false;
+        cache.dirty = false;
+        return false;
+    }
+
+    const auto textureWidth = static_cast<uint16_t>(width);
+    const auto textureHeight = static_cast<uint16_t>(height);
+    if (!bgfx::isValid(cache.frameBuffer) || cache.width != textureWidth || cache.height != textureHeight) {
+        if (bgfx::isValid(cache.frameBuffer)) {
+            bgfx::destroy(cache.frameBuffer);
+        }
+        cache.texture = bgfx::createTexture2D(
+            textureWidth,
+            textureHeight,
+            false,
+            1,
+            bgfx::TextureFormat::RGBA8,
+            BGFX_TEXTURE_RT | BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP
+        );
+        cache.frameBuffer = bgfx::createFrameBuffer(1, &cache.texture, true);
+        cache.width = textureWidth;
+        cache.height = textureHeight;
+    }
+
+    float proj[16];
+    bx::mtxOrtho(proj, area.minX, area.maxX, area.maxY, area.minY, 0, 1, 0, false);
+    bgfx::setViewRect(view, 0, 0, textureWidth, textureHeight);
+    bgfx::setViewFrameBuffer(view, cache.frameBuffer);
+    bgfx::setViewClear(view, BGFX_CLEAR_COLOR, 0);
+    bgfx::setViewTransform(view, m_viewMatrix, proj);
+    bgfx::setViewMode(view, bgfx::ViewMode::DepthAscending);
+    bgfx::touch(view);
+
+    // the subtree is rendered with the main context, redirected to the cache's view
+    BatchContext& ctx = m_mainContext;
+    submitBatch(ctx);
+    const bgfx::ViewId savedView = ctx.view;
+    const math::Bounds savedBounds = ctx.viewBounds;
+    const uint32_t savedSegment = ctx.depthSegment, savedSequence = ctx.depthSequence;
+    const uint32_t savedTransform = ctx.transform;
+    const bool deferred = m_deferred;
+    ctx.view = view;
+    ctx.viewBounds = area;
+    ctx.transform = 0;
+    ctx.depthSegment = ctx.depthSequence = 0;
+    m_deferred = false; // the frame's draw list only targets the main view
+
+    cache.rendering = true;
+    pushTransform(math::affineInverse(world));
+    container.render(*this);
+    popTransform();
+    cache.rendering = false;
+
+    ctx.view = savedView;
+    ctx.viewBounds = savedBounds;
+    ctx.depthSegment = savedSegment;
+    ctx.depthSequence = savedSequence;
+    ctx.transform = savedTransform;
+    m_deferred = deferred;
+
+    // render targets are stored upside down on backends whose origin is the bottom left
+    const bool flip = bgfx::getCaps()->originBottomLeft;
+    const float top = flip ? 1.0f : 0.0f;
+    const float bottom = flip ? 0.0f : 1.0f;
+    cache.area = area;
+    cache.color = world.color;
+    cache.quad = {
+        // clang-format off
+        .vertices = {
+            {0, 0, 0, top,    Color::White},
+            {0, 0, 1, top,    Color::White},
+            {0, 0, 1, bottom, Color::White},
+            {0, 0, 0, bottom, Color::White},
+        },
+        // clang-format on
+        .indices = {0, 1, 2, 0, 2, 3},
+        .texture = cache.texture
+    };
+    cache.place(world);
+    cache.placedVersion = container.getWorldVersion();
+    cache.valid = true;
+    cache.dirty = false;
+    return true;
+}
+
+void RenderCache::place(const math::Affine& world) {
+    const math::Vec2f corners[4] = {{area.minX, area.minY}, {area.maxX, area.minY}, {area.maxX, area.maxY}, {area.minX, area.maxY}};
+    for (size_t i = 0; i < 4; i++) {
+        const auto [x, y] = math::affineApply(world, corners[i]);
+        quad.vertices[i].x = x;
+        quad.vertices[i].y = y;
+    }
 }
 
 void Renderer::render(Container& container) {
+    container.updateTransforms();
+
+    m_mainContext.encoder = bgfx::begin();
+    refreshCaches();
+    m_drawOrder = 0;
     container.render(*this);
-    if (!m_batchVertices.empty()) {
-        submitBatch();
-    } else {
-        bgfx::touch(0); // dummy draw call if nothing's being rendered
+    flushDrawList();
+    submitBatch(m_mainContext);
+    bgfx::end(m_mainContext.encoder);
+
+    FrameStats stats = m_mainContext.stats;
+    for (BatchContext& ctx : m_workerContexts) {
+        addCounters(stats, ctx.stats);
+        ctx.endFrame();
+    }
+    m_mainContext.endFrame();
+
+    if (stats.drawCalls == 0) {
+        bgfx::touch(MAIN_VIEW); // dummy draw call if nothing's being rendered
     }
     bgfx::frame();
+
+    const bgfx::Stats* bgfxStats = bgfx::getStats();
+    stats.cpuFrameMs = static_cast<double>(bgfxStats->cpuTimeFrame) * 1000.0 / static_cast<double>(bgfxStats->cpuTimerFreq);
+    if (bgfxStats->gpuTimerFreq > 0 && bgfxStats->gpuTimeEnd > bgfxStats->gpuTimeBegin) {
+        stats.gpuFrameMs = static_cast<double>(bgfxStats->gpuTimeEnd - bgfxStats->gpuTimeBegin) * 1000.0 / static_cast<double>(bgfxStats->gpuTimerFreq);
+    }
+    m_frameStats = stats;
+}
+
+void Renderer::BatchContext::endFrame() {
+    // transient buffers are only valid for a single frame
+    encoder = nullptr;
+    for (VertexChunk& chunk : vertexChunks) {
+        chunk.capacity = chunk.cursor = chunk.batchFirst = 0;
+        chunk.nextSize = std::max(chunk.written, MIN_CHUNK_VERTICES);
+        chunk.written = 0;
+    }
+    chunkIndexCapacity = chunkIndexCursor = 0;
+    chunkInstanceCapacity = chunkInstanceCursor = 0;
+    batchFirstIndex = batchFirstInstance = 0;
+    batchProgram = BatchProgram::Color;
+    batchBlend = BlendMode::Alpha;
+    batchTextureCount = 0;
+    nextChunkIndices = std::max(stats.indices, MIN_CHUNK_VERTICES / 2 * 3);
+    nextChunkInstances = std::max(stats.instances, MIN_CHUNK_INSTANCES);
+    depthSegment = depthSequence = 0;
+    transforms.clear();
+    transformStack.clear();
+    transform = 0;
+    stats = {};
 }
 
-void Renderer::shutdown() const {
+void Renderer::shutdown() {
+    m_workers.reset();
+    m_workerContexts.clear();
+
     bgfx::destroy(m_spriteProgram);
     bgfx::destroy(m_colorProgram);
-    bgfx::destroy(m_sampler);
+    bgfx::destroy(m_staticProgram);
+    bgfx::destroy(m_staticSpriteProgram);
+    if (bgfx::isValid(m_batchOriginUniform)) {
+        bgfx::destroy(m_batchOriginUniform);
+    }
+    if (m_instancing) {
+        bgfx::destroy(m_instancedProgram);
+        bgfx::destroy(m_quadVertices);
+        bgfx::destroy(m_quadIndices);
+    }
+    for (const bgfx::UniformHandle& sampler : m_samplers) {
+        bgfx::destroy(sampler);
+    }
     bgfx::shutdown();
+    m_initialized = false;
 }
 
 }
@@ -28,12 +28,18 @@ void SoundManager::init() {
 }
 
 void SoundManager::load(const std::string& name, const std::string& filePath) {
+    if (!m_initialized) {
+        return; // no audio device, such as in headless mode
+    }
     if (((m_sounds[name] = MIX_LoadAudio(m_mixer, filePath.c_str(), true))) == nullptr) {
         throw GmiException("Error loading sound '" + name + "': " + SDL_GetError());
     }
 }
 
 void SoundManager::play(const std::string& name) {
+    if (!m_initialized) {
+        return;
+    }
     if (!m_sounds.contains(name)) {
         throw GmiException("Unknown sound: '" + name + "'");
     }
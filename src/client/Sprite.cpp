@@ -1,4 +1,7 @@
+#include <algorithm>
+
 #include "gmi/client/Sprite.h"
+#include "gmi/client/SpriteBatch.h"
 
 namespace gmi {
 
@@ -7,50 +10,97 @@ Sprite::Sprite(Application* parentApp, Container* parent, const std::string& tex
     m_texture(parentApp->textures().get(textureName)) {
     m_transform = transform;
     m_transformDirty = true;
+
+    const auto& [handle, textureSize, frame] = m_texture;
+    auto tw = static_cast<float>(textureSize.w);
+    auto th = static_cast<float>(textureSize.h);
+    m_u0 = static_cast<float>(frame.x) / tw;
+    m_u1 = static_cast<float>(frame.x + frame.w) / tw;
+    m_v0 = static_cast<float>(frame.y) / th;
+    m_v1 = static_cast<float>(frame.y + frame.h) / th;
+    m_quad.texture = handle;
 }
 
-Sprite::~Sprite() = default;
+Sprite::~Sprite() {
+    if (m_batch != nullptr) {
+        m_batch->releaseSlot(m_batchSlot);
+    }
+}
 
 void Sprite::updateAffine() {
     Container::updateAffine();
 
-    auto& [handle, textureSize, frame] = m_texture;
+    // only rebuild the quad if this sprite or one of its ancestors actually changed
+    if (m_quadLocalVersion == m_localVersion && m_quadWorldVersion == m_worldVersion) {
+        return;
+    }
+    m_quadLocalVersion = m_localVersion;
+    m_quadWorldVersion = m_worldVersion;
 
+    const auto& frame = m_texture.frame;
     math::Affine affineScaled = m_affine * math::Affine::scaleAbout(m_transform.pivot, math::Vec2f(frame.w, frame.h));
 
-    auto tw = static_cast<float>(textureSize.w);
-    auto th = static_cast<float>(textureSize.h);
-    auto fx = static_cast<float>(frame.x);
-    auto fy = static_cast<float>(frame.y);
-    auto fw = static_cast<float>(frame.w);
-    auto fh = static_cast<float>(frame.h);
-
-    float lx = fx / tw; // left X
-    float rx = (fx + fw) / tw; // right X
-    float ty = fy / th; // top Y
-    float by = (fy + fh) / th; // bottom Y
+    const float lx = m_u0; // left X
+    const float rx = m_u1; // right X
+    const float ty = m_v0; // top Y
+    const float by = m_v1; // bottom Y
 
     auto [a, b, c, d, x, y, color] = affineScaled;
 
-    m_drawable = {
-        // clang-format off
-        .vertices = {
-            {c + x,     d + y,     lx, by, color}, // Top left
-            {a + c + x, b + d + y, rx, by, color}, // Top right
-            {a + x,     b + y,     rx, ty, color}, // Bottom right
-            {x,         y,         lx, ty, color}, // Bottom left
-        },
-        // clang-format on
-        .indices = {0, 1, 2, 0, 2, 3},
-        .texture = handle
-    };
+    m_quadBounds = {};
+    m_quadBounds.extend(x, y);
+    m_quadBounds.extend(a + x, b + y);
+    m_quadBounds.extend(c + x, d + y);
+    m_quadBounds.extend(a + c + x, b + d + y);
+
+    if (m_batch != nullptr) {
+        // hidden sprites keep their slot, but as a degenerate quad
+        Vertex* out = m_batch->slotVertices(m_batchSlot);
+        if (m_visible) {
+            auto slot = static_cast<float>(m_batchTextureSlot);
+            // clang-format off
+            out[0] = {c + x,     d + y,     lx, by, color, slot}; // Top left
+            out[1] = {a + c + x, b + d + y, rx, by, color, slot}; // Top right
+            out[2] = {a + x,     b + y,     rx, ty, color, slot}; // Bottom right
+            out[3] = {x,         y,         lx, ty, color, slot}; // Bottom left
+            // clang-format on
+        } else {
+            std::fill_n(out, 4, Vertex{});
+        }
+        m_batch->markSlotDirty(m_batchSlot);
+        return;
+    }
+
+    if (m_parentApp->renderer().isInstancing()) {
+        // the unit quad is expanded on the GPU
+        m_instance = {
+            .a = a, .b = b, .c = c, .d = d,
+            .x = x, .y = y,
+            .u0 = lx, .v0 = ty,
+            .u1 = rx, .v1 = by,
+        };
+        m_instance.setColor(color);
+        return;
+    }
+
+    Vertex* out = m_quad.vertices;
+    // clang-format off
+    out[0] = {c + x,     d + y,     lx, by, color}; // Top left
+    out[1] = {a + c + x, b + d + y, rx, by, color}; // Top right
+    out[2] = {a + x,     b + y,     rx, ty, color}; // Bottom right
+    out[3] = {x,         y,         lx, ty, color}; // Bottom left
+    // clang-format on
 }
 
 void Sprite::render(Renderer& renderer) {
     Container::render(renderer);
 
-    if (m_visible) {
-        renderer.queueDrawable(m_drawable);
+    if (!m_skipDraw) {
+        if (renderer.isInstancing()) {
+            renderer.queueInstance(m_texture.handle, m_instance, drawOrder(renderer));
+        } else {
+            renderer.queueQuad(m_quad, drawOrder(renderer));
+        }
     }
 }
 
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <bit>
+#include <format>
+
+#include "gmi/client/SpriteBatch.h"
+#include "gmi/client/Sprite.h"
+#include "gmi/client/gmi.h"
+
+namespace gmi {
+
+SpriteBatch::SpriteBatch(Application* parentApp, Container* parent, const math::Transform& transform) :
+    Container(parentApp, parent, transform) { }
+
+SpriteBatch::~SpriteBatch() {
+    // the sprites are destroyed after this batch, so they must not release their slots
+    for (Sprite* sprite : m_slots) {
+        if (sprite != nullptr) {
+            sprite->m_batch = nullptr;
+        }
+    }
+    destroyBuffers();
+}
+
+Sprite& SpriteBatch::createSprite(const std::string& textureName, const math::Transform& transform) {
+    Sprite& sprite = createChild<Sprite>(textureName, transform);
+    uint8_t textureSlot;
+    try {
+        textureSlot = acquireTextureSlot(sprite.getTexture().handle);
+    } catch (...) {
+        removeChild(&sprite);
+        throw;
+    }
+
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(m_slots.size());
+        m_slots.push_back(nullptr);
+        m_slotDirty.push_back(0);
+        m_vertices.resize(m_vertices.size() + VERTICES_PER_SPRITE);
+    }
+    m_slots[slot] = &sprite;
+    m_slotsInUse = std::max(m_slotsInUse, slot + 1);
+    m_spriteCount++;
+
+    // the quad is written by the sprite's next transform update
+    sprite.m_batch = this;
+    sprite.m_batchSlot = slot;
+    sprite.m_batchTextureSlot = textureSlot;
+    return sprite;
+}
+
+uint8_t SpriteBatch::acquireTextureSlot(bgfx::TextureHandle texture) {
+    auto it = std::ranges::find_if(m_textures, [texture](bgfx::TextureHandle t) { return t.idx == texture.idx; });
+    if (it != m_textures.end()) {
+        return static_cast<uint8_t>(it - m_textures.begin());
+    }
+
+    uint8_t maxTextures = m_parentApp->renderer().getMaxTextureSlots();
+    if (m_textures.size() == maxTextures) {
+        throw GmiException(std::format("A SpriteBatch can use at most {} textures", maxTextures));
+    }
+    m_textures.push_back(texture);
+    return static_cast<uint8_t>(m_textures.size() - 1);
+}
+
+void SpriteBatch::markSlotDirty(uint32_t slot) {
+    if (m_slotDirty[slot] == 0) {
+        m_slotDirty[slot] = 1;
+        m_dirtySlots.push_back(slot);
+    }
+}
+
+void SpriteBatch::releaseSlot(uint32_t slot) {
+    m_slots[slot] = nullptr;
+    std::fill_n(slotVertices(slot), VERTICES_PER_SPRITE, Vertex{});
+    markSlotDirty(slot);
+    m_freeSlots.push_back(slot);
+    m_spriteCount--;
+
+    while (m_slotsInUse > 0 && m_slots[m_slotsInUse - 1] == nullptr) {
+        m_slotsInUse--;
+    }
+}
+
+void SpriteBatch::upload(Renderer& renderer) {
+    if (m_slots.size() > m_bufferCapacity) {
+        createBuffers(renderer);
+        return;
+    }
+    if (m_dirtySlots.empty()) {
+        return;
+    }
+
+    // coalesce dirty slots into runs, each uploaded with a single update
+    std::ranges::sort(m_dirtySlots);
+    auto uploadRun = [&](uint32_t first, uint32_t last) {
+        uint32_t numVertices = (last - first + 1) * VERTICES_PER_SPRITE;
+        renderer.updateDynamic(
+            m_vertexBuffer,
+            first * VERTICES_PER_SPRITE,
+            bgfx::copy(slotVertices(first), numVertices * sizeof(Vertex))
+        );
+    };
+    uint32_t first = m_dirtySlots[0];
+    uint32_t last = first;
+    for (uint32_t slot : m_dirtySlots) {
+        if (slot - last > MERGE_GAP) {
+            uploadRun(first, last);
+            first = slot;
+        }
+        last = slot;
+        m_slotDirty[slot] = 0;
+    }
+    uploadRun(first, last);
+    m_dirtySlots.clear();
+}
+
+void SpriteBatch::createBuffers(Renderer& renderer) {
+    destroyBuffers();
+
+    // the buffers only grow, geometrically, so they are rarely rebuilt
+    uint32_t capacity = std::max(MIN_CAPACITY, std::bit_ceil(static_cast<uint32_t>(m_slots.size())));
+    uint32_t numVertices = capacity * VERTICES_PER_SPRITE;
+    bool index32 = numVertices > UINT16_MAX + 1;
+    if (index32 && (bgfx::getCaps()->supported & BGFX_CAPS_INDEX32) == 0) {
+        throw GmiException(std::format(
+            "SpriteBatch needs room for {} sprites, but the renderer only supports {} sprites per draw call",
+            capacity,
+            (UINT16_MAX + 1) / VERTICES_PER_SPRITE
+        ));
+    }
+
+    m_vertexBuffer = bgfx::createDynamicVertexBuffer(numVertices, renderer.getVertexLayout());
+    renderer.updateDynamic(m_vertexBuffer, 0, bgfx::copy(m_vertices.data(), m_vertices.size() * sizeof(Vertex)));
+
+    // every slot shares the same quad pattern
+    uint32_t numIndices = capacity * INDICES_PER_SPRITE;
+    const bgfx::Memory* mem = bgfx::alloc(numIndices * (index32 ? sizeof(uint32_t) : sizeof(uint16_t)));
+    for (uint32_t i = 0; i < numIndices; i++) {
+        uint32_t index = i / INDICES_PER_SPRITE * VERTICES_PER_SPRITE + QUAD_INDICES[i % INDICES_PER_SPRITE];
+        if (index32) {
+            reinterpret_cast<uint32_t*>(mem->data)[i] = index;
+        } else {
+            reinterpret_cast<uint16_t*>(mem->data)[i] = static_cast<uint16_t>(index);
+        }
+    }
+    m_indexBuffer = bgfx::createIndexBuffer(mem, index32 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
+    m_bufferCapacity = capacity;
+
+    for (uint32_t slot : m_dirtySlots) {
+        m_slotDirty[slot] = 0;
+    }
+    m_dirtySlots.clear();
+}
+
+void SpriteBatch::destroyBuffers() {
+    // the buffers are already gone if the renderer was shut down before the scene was destroyed
+    if (bgfx::isValid(m_vertexBuffer) && m_parentApp->renderer().isInitialized()) {
+        bgfx::destroy(m_vertexBuffer);
+        bgfx::destroy(m_indexBuffer);
+    }
+    m_vertexBuffer = BGFX_INVALID_HANDLE;
+    m_indexBuffer = BGFX_INVALID_HANDLE;
+    m_bufferCapacity = 0;
+}
+
+void SpriteBatch::renderContent(Renderer& renderer) {
+    upload(renderer);
+    if (m_slotsInUse > 0) {
+        renderer.queueStatic(m_vertexBuffer, m_indexBuffer, m_slotsInUse * INDICES_PER_SPRITE, m_textures, drawOrder(renderer));
+    }
+
+    if (m_spriteCount == m_children.size()) {
+        return;
+    }
+    for (const auto& child : m_children) {
+        auto* sprite = dynamic_cast<Sprite*>(child.get());
+        if (sprite == nullptr || sprite->m_batch != this) {
+            renderChild(renderer, *child);
+        }
+    }
+}
+
+}
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -14,6 +15,96 @@
 
 namespace gmi {
 
+void TextureManager::enableAtlas(uint32_t pageSize, uint32_t padding) {
+    m_atlas = true;
+    m_atlasPageSize = std::min<uint32_t>(pageSize, bgfx::getCaps()->limits.maxTextureSize);
+    m_atlasPadding = padding;
+}
+
+bool TextureManager::addToAtlas(const std::string& name, const bimg::ImageContainer& image) {
+    const uint32_t width = image.m_width;
+    const uint32_t height = image.m_height;
+    const uint32_t paddedWidth = width + 2 * m_atlasPadding;
+    const uint32_t paddedHeight = height + 2 * m_atlasPadding;
+    if (image.m_numMips > 1 || paddedWidth > m_atlasPageSize || paddedHeight > m_atlasPageSize) {
+        return false;
+    }
+
+    // pages share a single format, so other formats are decoded first
+    bimg::ImageContainer* converted = nullptr;
+    if (image.m_format != bimg::TextureFormat::RGBA8) {
+        converted = bimg::imageConvert(&m_allocator, bimg::TextureFormat::RGBA8, image, false);
+        if (converted == nullptr) {
+            return false;
+        }
+    }
+    const auto* pixels = static_cast<const uint32_t*>(converted != nullptr ? converted->m_data : image.m_data);
+
+    // first fit among the existing pages, so earlier pages fill up before new ones are created
+    AtlasPage* page = nullptr;
+    std::optional<math::UintRect> rect;
+    for (AtlasPage& candidate : m_atlasPages) {
+        rect = candidate.packer.insert(paddedWidth, paddedHeight);
+        if (rect.has_value()) {
+            page = &candidate;
+            break;
+        }
+    }
+    if (page == nullptr) {
+        const auto size = static_cast<uint16_t>(m_atlasPageSize);
+        bgfx::TextureHandle handle = bgfx::createTexture2D(size, size, false, 1, bgfx::TextureFormat::RGBA8);
+        if (!bgfx::isValid(handle)) {
+            if (converted != nullptr) {
+                bimg::imageFree(converted);
+            }
+            throw GmiException("Failed to load texture '" + name + "': Unable to create an atlas page");
+        }
+        m_handles.push_back(handle);
+        page = &m_atlasPages.emplace_back(AtlasPage{handle, math::RectPacker(m_atlasPageSize, m_atlasPageSize)});
+        rect = page->packer.insert(paddedWidth, paddedHeight);
+    }
+
+    // the image is copied with its edges extended into the padding
+    const bgfx::Memory* mem = bgfx::alloc(paddedWidth * paddedHeight * sizeof(uint32_t));
+    auto* out = reinterpret_cast<uint32_t*>(mem->data);
+    const auto padding = static_cast<int64_t>(m_atlasPadding);
+    for (uint32_t y = 0; y < paddedHeight; y++) {
+        const auto srcY = static_cast<uint32_t>(std::clamp<int64_t>(y - padding, 0, height - 1));
+        for (uint32_t x = 0; x < paddedWidth; x++) {
+            const auto srcX = static_cast<uint32_t>(std::clamp<int64_t>(x - padding, 0, width - 1));
+            out[y * paddedWidth + x] = pixels[srcY * width + srcX];
+        }
+    }
+    bgfx::updateTexture2D(
+        page->handle,
+        0,
+        0,
+        static_cast<uint16_t>(rect->x),
+        static_cast<uint16_t>(rect->y),
+        static_cast<uint16_t>(paddedWidth),
+        static_cast<uint16_t>(paddedHeight),
+        mem
+    );
+    if (converted != nullptr) {
+        bimg::imageFree(converted);
+    }
+
+    m_textures[name] = {
+        .handle = page->handle,
+        .size = {
+            .w = m_atlasPageSize,
+            .h = m_atlasPageSize
+        },
+        .frame = {
+            .x = rect->x + m_atlasPadding,
+            .y = rect->y + m_atlasPadding,
+            .w = width,
+            .h = height,
+        }
+    };
+    return true;
+}
+
 void TextureManager::load(const std::string& name, const std::string& filePath) {
     if (m_textures.contains(name)) {
         throw GmiException("Failed to load texture '" + name + "': Texture already exists");
@@ -32,6 +123,14 @@ void TextureManager::load(const std::string& name, const std::string& filePath)
     stream.read(data, size);
 
     bimg::ImageContainer* image = bimg::imageParse(&m_allocator, data, size);
+    if (image == nullptr) {
+        throw GmiException("Failed to load texture '" + name + "': Unsupported image format");
+    }
+    if (m_atlas && addToAtlas(name, *image)) {
+        bimg::imageFree(image);
+        return;
+    }
+
     uint32_t width = image->m_width;
     uint32_t height = image->m_height;
     bgfx::TextureHandle handle = bgfx::createTexture2D(
@@ -104,11 +203,17 @@ void TextureManager::loadSpritesheet(const std::string& name, const std::string&
     load(name, sheetPath);
     Texture texture = m_textures[name];
 
+    // frames are relative to the sheet, which may itself be packed into an atlas page
     for (const auto& [subName, frame] : sheet.frames) {
         m_textures[subName] = {
             .handle = texture.handle,
             .size = texture.size,
-            .frame = frame.frame,
+            .frame = {
+                .x = texture.frame.x + frame.frame.x,
+                .y = texture.frame.y + frame.frame.y,
+                .w = frame.frame.w,
+                .h = frame.frame.h,
+            },
         };
     }
 }
@@ -1,88 +1,276 @@
 #include "gmi/client/TweenManager.h"
 
+#include <algorithm>
+#include <format>
+#include <optional>
+#include <span>
+
 #include "gmi/client/gmi.h"
 
 namespace gmi {
 
-uint16_t TweenManager::add(const TweenOptions& opts) {
+namespace {
+
+constexpr uint32_t NO_TWEEN = UINT32_MAX;
+
+/** Moves the surviving entries of a tween array to their new indices, as given by the remap table. */
+template<typename T>
+void compactArray(std::vector<T>& values, const std::vector<uint32_t>& remap, uint32_t count) {
+    for (size_t i = 0; i < remap.size(); i++) {
+        if (remap[i] != NO_TWEEN) {
+            values[remap[i]] = std::move(values[i]);
+        }
+    }
+    values.resize(count);
+}
+
+}
+
+struct TweenManager::Callbacks {
+    std::function<void()> onUpdate;
+    std::function<void()> onChange;
+    std::function<void()> onComplete;
+    uint32_t tween;
+};
+
+TweenManager::TweenManager() = default;
+
+TweenManager::~TweenManager() = default;
+
+TweenHandle TweenManager::add(const TweenOptions& opts) {
     if (opts.duration <= 0) {
         throw GmiException("Tween duration must be greater than zero");
     }
+    if (opts.ease == nullptr) {
+        throw GmiException("Tween easing must not be null");
+    }
+    for (const TweenVar& v : opts.values) {
+        if (v.var == nullptr) {
+            throw GmiException("Attempted to tween a value that does not exist");
+        }
+    }
+
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        if (m_slotTweens.size() >= MAX_TWEENS) {
+            throw GmiException(std::format("Cannot have more than {} active tweens", MAX_TWEENS));
+        }
+        slot = static_cast<uint32_t>(m_slotTweens.size());
+        m_slotTweens.push_back(NO_TWEEN);
+        m_slotGenerations.push_back(1);
+    }
+
+    const auto tween = static_cast<uint32_t>(m_slots.size());
+    m_slotTweens[slot] = tween;
+    m_startTimes.push_back(m_now);
+    m_durations.push_back(opts.duration);
+    m_invDurations.push_back(1.0f / static_cast<float>(opts.duration));
+    const std::optional<math::EasingId> easing = math::getEasingId(opts.ease);
+    m_easings.push_back(easing.value_or(CUSTOM_EASING));
+    if (!easing.has_value()) {
+        m_customEasings.push_back({tween, opts.ease});
+    }
+    m_flags.push_back((opts.yoyo ? Yoyo : 0) | (opts.infinite ? Infinite : 0));
+    m_slots.push_back(slot);
+
+    for (const TweenVar& v : opts.values) {
+        m_targets.push_back(v.var);
+        m_startValues.push_back(*v.var);
+        m_endValues.push_back(v.endValue);
+        m_valueTweens.push_back(tween);
+    }
+
+    if (opts.onUpdate || opts.onChange || opts.onComplete) {
+        m_callbacks.push_back(std::make_unique<Callbacks>(opts.onUpdate, opts.onChange, opts.onComplete, tween));
+    }
 
-    auto tween = Tween(opts);
-    tween.startTime = nowMs();
-    tween.endTime = tween.startTime + tween.opts.duration;
-    for (auto& var : tween.opts.values) {
-        var.startValue = *var.var;
+    return {slot | static_cast<uint32_t>(m_slotGenerations[slot]) << INDEX_BITS};
+}
+
+bool TweenManager::kill(TweenHandle handle) {
+    if (!isActive(handle)) {
+        return false;
     }
-    uint16_t id = m_nextId;
-    m_tweens.emplace(id, tween);
-    m_nextId++;
-    return id;
+    retire(m_slotTweens[handle.value & INDEX_MASK]);
+    return true;
 }
 
-bool TweenManager::kill(uint16_t id) {
-    return static_cast<bool>(m_tweens.erase(id));
+bool TweenManager::isActive(TweenHandle handle) const {
+    const uint32_t slot = handle.value & INDEX_MASK;
+    return slot < m_slotTweens.size()
+        && m_slotGenerations[slot] == handle.value >> INDEX_BITS
+        && m_slotTweens[slot] != NO_TWEEN;
 }
 
-void TweenManager::update() {
-    uint64_t now = nowMs();
-    auto iter = m_tweens.begin();
-    while (iter != m_tweens.end()) {
-        Tween& tween = iter->second;
-        TweenOptions& opts = tween.opts;
-        const float factor = std::clamp(static_cast<float>(now - tween.startTime) / opts.duration, 0.0f, 1.0f);
-        const float eased = opts.ease(factor);
-
-        for (const TweenVar& v : opts.values) {
-            if (v.var == nullptr) {
-                throw GmiException("Attempted to tween a value that no longer exists");
-            }
-            *v.var = math::lerp(v.startValue, v.endValue, eased);
+void TweenManager::reserve(uint32_t tweens, uint32_t values) {
+    m_slotTweens.reserve(tweens);
+    m_slotGenerations.reserve(tweens);
+    m_startTimes.reserve(tweens);
+    m_durations.reserve(tweens);
+    m_invDurations.reserve(tweens);
+    m_easings.reserve(tweens);
+    m_flags.reserve(tweens);
+    m_slots.reserve(tweens);
+    m_targets.reserve(values);
+    m_startValues.reserve(values);
+    m_endValues.reserve(values);
+    m_valueTweens.reserve(values);
+}
+
+void TweenManager::retire(uint32_t tween) {
+    m_flags[tween] |= Dead;
+    m_deadCount++;
+
+    // the slot is free right away, with a new generation so the old handle no longer matches
+    const uint32_t slot = m_slots[tween];
+    m_slotTweens[slot] = NO_TWEEN;
+    m_slotGenerations[slot] = m_slotGenerations[slot] == MAX_GENERATION ? 1 : m_slotGenerations[slot] + 1;
+    m_freeSlots.push_back(slot);
+}
+
+void TweenManager::compact() {
+    const auto count = static_cast<uint32_t>(m_slots.size());
+    m_remap.resize(count);
+    uint32_t alive = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        m_remap[i] = m_flags[i] & Dead ? NO_TWEEN : alive++;
+    }
+
+    compactArray(m_startTimes, m_remap, alive);
+    compactArray(m_durations, m_remap, alive);
+    compactArray(m_invDurations, m_remap, alive);
+    compactArray(m_easings, m_remap, alive);
+    compactArray(m_flags, m_remap, alive);
+    compactArray(m_slots, m_remap, alive);
+    for (uint32_t i = 0; i < alive; i++) {
+        m_slotTweens[m_slots[i]] = i;
+    }
+
+    size_t values = 0;
+    for (size_t v = 0; v < m_targets.size(); v++) {
+        const uint32_t tween = m_remap[m_valueTweens[v]];
+        if (tween != NO_TWEEN) {
+            m_targets[values] = m_targets[v];
+            m_startValues[values] = m_startValues[v];
+            m_endValues[values] = m_endValues[v];
+            m_valueTweens[values] = tween;
+            values++;
         }
+    }
+    m_targets.resize(values);
+    m_startValues.resize(values);
+    m_endValues.resize(values);
+    m_valueTweens.resize(values);
+
+    std::erase_if(m_customEasings, [this](const CustomEasing& easing) { return m_remap[easing.tween] == NO_TWEEN; });
+    for (CustomEasing& easing : m_customEasings) {
+        easing.tween = m_remap[easing.tween];
+    }
+
+    std::erase_if(m_callbacks, [this](const std::unique_ptr<Callbacks>& callbacks) {
+        return m_remap[callbacks->tween] == NO_TWEEN;
+    });
+    for (const std::unique_ptr<Callbacks>& callbacks : m_callbacks) {
+        callbacks->tween = m_remap[callbacks->tween];
+    }
+
+    m_deadCount = 0;
+}
+
+void TweenManager::update(uint64_t now) {
+    m_now = now;
+    if (m_deadCount > 0) {
+        compact();
+    }
+
+    const auto count = static_cast<uint32_t>(m_slots.size());
+    m_weights.resize(count);
+    m_changed.resize(count);
+    m_completed.resize(count);
+
+    // Progress of every tween, and the list of tweens reaching their end
+    uint32_t numCompleted = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        const uint64_t elapsed = now - m_startTimes[i];
+        m_weights[i] = std::min(static_cast<float>(elapsed) * m_invDurations[i], 1.0f);
+        m_changed[i] = 0;
+        m_completed[numCompleted] = i;
+        numCompleted += elapsed >= m_durations[i];
+    }
 
-        if (opts.onUpdate)
-            opts.onUpdate();
-
-        if (now >= tween.endTime) {
-            if (opts.yoyo) {
-                for (auto& var : opts.values) {
-                    std::swap(var.endValue, var.startValue);
-                }
-
-                if (!opts.infinite) {
-                    opts.yoyo = false;
-                }
-
-                tween.startTime = now;
-                tween.endTime = tween.startTime + opts.duration;
-            } else if (opts.infinite) {
-                for (const TweenVar& v : opts.values) {
-                    if (v.var == nullptr) {
-                        throw GmiException("Attempted to tween a value that no longer exists");
-                    }
-                    *v.var = v.startValue;
-                }
-
-                tween.startTime = now;
-                tween.endTime = tween.startTime + opts.duration;
-            } else {
-                for (const TweenVar& v : opts.values) {
-                    if (v.var == nullptr) {
-                        throw GmiException("Attempted to tween a value that no longer exists");
-                    }
-                    *v.var = v.endValue;
-                }
-
-                if (opts.onComplete)
-                    opts.onComplete();
-
-                iter = m_tweens.erase(iter);
-                continue;
+    // Tweens started together usually share an easing, so runs of the same easing are eased in one call
+    for (uint32_t first = 0; first < count;) {
+        const math::EasingId easing = m_easings[first];
+        uint32_t last = first + 1;
+        while (last < count && m_easings[last] == easing) {
+            last++;
+        }
+        if (easing != CUSTOM_EASING) {
+            const std::span<float> run = std::span(m_weights).subspan(first, last - first);
+            m_easingTables.ease(easing, run, run);
+        }
+        first = last;
+    }
+    for (const CustomEasing& easing : m_customEasings) {
+        m_weights[easing.tween] = easing.fn(m_weights[easing.tween]);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const float eased = m_weights[i];
+        m_weights[i] = m_flags[i] & Reversed ? 1.0f - eased : eased;
+    }
+
+    // Tweens reaching their end snap to it, except infinite ones without yoyo which jump back to their start
+    for (uint32_t c = 0; c < numCompleted; c++) {
+        const uint32_t i = m_completed[c];
+        const bool atStart = (m_flags[i] & (Yoyo | Infinite)) == Infinite;
+        m_weights[i] = atStart == static_cast<bool>(m_flags[i] & Reversed) ? 1.0f : 0.0f;
+    }
+
+    for (size_t v = 0, numValues = m_targets.size(); v < numValues; v++) {
+        const float value = math::lerp(m_startValues[v], m_endValues[v], m_weights[m_valueTweens[v]]);
+        m_changed[m_valueTweens[v]] |= *m_targets[v] != value;
+        *m_targets[v] = value;
+    }
+
+    for (uint32_t c = 0; c < numCompleted; c++) {
+        const uint32_t i = m_completed[c];
+        uint8_t& flags = m_flags[i];
+        if (flags & Yoyo) {
+            flags ^= Reversed;
+            if (!(flags & Infinite)) {
+                flags &= ~Yoyo;
             }
+            m_startTimes[i] = now;
+        } else if (flags & Infinite) {
+            m_startTimes[i] = now;
+        } else {
+            flags |= Finished;
         }
+    }
 
-        ++iter;
+    // Callbacks may add or kill tweens: added ones are appended past the end, killed ones are only flagged
+    for (size_t c = 0, numCallbacks = m_callbacks.size(); c < numCallbacks; c++) {
+        Callbacks* callbacks = m_callbacks[c].get();
+        const uint32_t i = callbacks->tween;
+        if (m_flags[i] & Dead) {
+            continue;
+        }
+        if (callbacks->onUpdate)
+            callbacks->onUpdate();
+        if (m_changed[i] && callbacks->onChange && !(m_flags[i] & Dead))
+            callbacks->onChange();
+        if (m_flags[i] & Finished && callbacks->onComplete && !(m_flags[i] & Dead))
+            callbacks->onComplete();
+    }
+
+    for (uint32_t c = 0; c < numCompleted; c++) {
+        const uint32_t i = m_completed[c];
+        if ((m_flags[i] & (Finished | Dead)) == Finished) {
+            retire(i);
+        }
     }
 }
 
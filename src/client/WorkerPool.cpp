@@ -0,0 +1,71 @@
+#include <utility>
+
+#include "WorkerPool.h"
+
+namespace gmi::internal {
+
+WorkerPool::WorkerPool(uint32_t numWorkers) {
+    m_threads.reserve(numWorkers);
+    for (uint32_t i = 0; i < numWorkers; i++) {
+        m_threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(uint32_t numJobs, const Job& job) {
+    std::unique_lock lock(m_mutex);
+    m_job = &job;
+    m_numJobs = numJobs;
+    m_nextJob = 0;
+    m_busyWorkers = size();
+    m_generation++;
+    m_wake.notify_all();
+
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_job = nullptr;
+    if (m_error != nullptr) {
+        std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+}
+
+void WorkerPool::workerLoop(uint32_t worker) {
+    uint64_t generation = 0;
+    while (true) {
+        std::unique_lock lock(m_mutex);
+        m_wake.wait(lock, [this, generation] { return m_stopping || m_generation != generation; });
+        if (m_stopping) {
+            return;
+        }
+        generation = m_generation;
+        lock.unlock();
+
+        // jobs are claimed one at a time, so uneven jobs are balanced between the workers
+        for (uint32_t job = m_nextJob++; job < m_numJobs; job = m_nextJob++) {
+            try {
+                (*m_job)(job, worker);
+            } catch (...) {
+                std::lock_guard errorLock(m_mutex);
+                if (m_error == nullptr) {
+                    m_error = std::current_exception();
+                }
+            }
+        }
+
+        lock.lock();
+        if (--m_busyWorkers == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+}
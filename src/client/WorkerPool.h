@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gmi::internal {
+
+/**
+ * A fixed set of threads that run batches of jobs, used by the @ref Renderer to build batches in parallel.
+ */
+class WorkerPool {
+public:
+    /**
+     * A job. Receives the index of the job and the index of the worker running it,
+     * so workers can keep per-thread state in an array.
+     */
+    using Job = std::function<void(uint32_t job, uint32_t worker)>;
+
+    explicit WorkerPool(uint32_t numWorkers);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /** @return The number of worker threads. */
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(m_threads.size()); }
+
+    /**
+     * Runs jobs on the workers and blocks until all of them are done.
+     * If a job throws, the first exception is rethrown once all jobs have finished.
+     * @param numJobs The number of jobs
+     * @param job The function to run for every job
+     */
+    void run(uint32_t numJobs, const Job& job);
+private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake, m_done;
+    uint64_t m_generation = 0;
+    uint32_t m_busyWorkers = 0;
+    bool m_stopping = false;
+
+    const Job* m_job = nullptr;
+    uint32_t m_numJobs = 0;
+    std::atomic<uint32_t> m_nextJob = 0;
+    std::exception_ptr m_error;
+
+    void workerLoop(uint32_t worker);
+};
+
+}
@@ -0,0 +1,306 @@
+#include "quadKernel.h"
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GMI_QUAD_SSE2 1
+#include <emmintrin.h>
+// AVX2 is compiled per function and only used if the CPU supports it
+#if defined(__GNUC__) || defined(__clang__)
+#define GMI_QUAD_AVX2 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define GMI_QUAD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace gmi::internal {
+
+// SIMD kernels write x, y, u, v as one 16-byte store, then the color and texture slot
+static_assert(offsetof(Vertex, x) == 0 && offsetof(Vertex, v) == 12 && offsetof(Vertex, color) == 16);
+static_assert(sizeof(Color) == 4 && sizeof(Vertex) == 24);
+
+void QuadArrays::clear() {
+    for (auto* array : {&a, &b, &c, &d, &x, &y, &w, &h, &pivotX, &pivotY, &u0, &v0, &u1, &v1}) {
+        array->clear();
+    }
+    colors.clear();
+}
+
+void QuadArrays::reserve(size_t count) {
+    for (auto* array : {&a, &b, &c, &d, &x, &y, &w, &h, &pivotX, &pivotY, &u0, &v0, &u1, &v1}) {
+        array->reserve(count);
+    }
+    colors.reserve(count);
+}
+
+void QuadArrays::push(const math::Affine& world, float frameW, float frameH, math::Vec2f pivot, float uvU0, float uvV0, float uvU1, float uvV1) {
+    a.push_back(world.a);
+    b.push_back(world.b);
+    c.push_back(world.c);
+    d.push_back(world.d);
+    x.push_back(world.x);
+    y.push_back(world.y);
+    w.push_back(frameW);
+    h.push_back(frameH);
+    pivotX.push_back(pivot.x);
+    pivotY.push_back(pivot.y);
+    u0.push_back(uvU0);
+    v0.push_back(uvV0);
+    u1.push_back(uvU1);
+    v1.push_back(uvV1);
+    colors.push_back(world.color);
+}
+
+QuadInputs QuadArrays::inputs() const {
+    return {
+        a.data(), b.data(), c.data(), d.data(), x.data(), y.data(),
+        w.data(), h.data(),
+        pivotX.data(), pivotY.data(),
+        u0.data(), v0.data(), u1.data(), v1.data(),
+        colors.data(),
+    };
+}
+
+/** Writes the color and texture slot of a quad's vertices, whose x, y, u and v were already stored. */
+static void setQuadColor(Vertex* quad, Color color, float textureSlot) {
+    for (int k = 0; k < 4; k++) {
+        quad[k].color = color;
+        quad[k].textureSlot = textureSlot;
+    }
+}
+
+void buildQuadsScalar(const QuadInputs& in, size_t begin, size_t end, Vertex* out, float textureSlot) {
+    for (size_t i = begin; i < end; i++) {
+        // world * scaleAbout(pivot, frame size), expanded
+        const float qa = in.a[i] * in.w[i];
+        const float qb = in.b[i] * in.w[i];
+        const float qc = in.c[i] * in.h[i];
+        const float qd = in.d[i] * in.h[i];
+        const float sx = in.pivotX[i] * (1.0f - in.w[i]);
+        const float sy = in.pivotY[i] * (1.0f - in.h[i]);
+        const float qx = in.a[i] * sx + in.c[i] * sy + in.x[i];
+        const float qy = in.b[i] * sx + in.d[i] * sy + in.y[i];
+
+        // added in the same order as the SIMD kernels, so results are identical
+        const float tlx = qc + qx;
+        const float tly = qd + qy;
+
+        const Color color = in.colors[i];
+        Vertex* quad = out + i * 4;
+        // clang-format off
+        quad[0] = {tlx,      tly,      in.u0[i], in.v1[i], color, textureSlot}; // Top left
+        quad[1] = {qa + tlx, qb + tly, in.u1[i], in.v1[i], color, textureSlot}; // Top right
+        quad[2] = {qa + qx,  qb + qy,  in.u1[i], in.v0[i], color, textureSlot}; // Bottom right
+        quad[3] = {qx,       qy,       in.u0[i], in.v0[i], color, textureSlot}; // Bottom left
+        // clang-format on
+    }
+}
+
+#if GMI_QUAD_SSE2
+
+/** Stores one corner of 4 quads, from the corner's x, y, u and v of each quad. */
+static void storeCornerSse2(Vertex* out, int corner, __m128 x, __m128 y, __m128 u, __m128 v) {
+    const __m128 xyLo = _mm_unpacklo_ps(x, y);
+    const __m128 xyHi = _mm_unpackhi_ps(x, y);
+    const __m128 uvLo = _mm_unpacklo_ps(u, v);
+    const __m128 uvHi = _mm_unpackhi_ps(u, v);
+    _mm_storeu_ps(&out[0 * 4 + corner].x, _mm_movelh_ps(xyLo, uvLo));
+    _mm_storeu_ps(&out[1 * 4 + corner].x, _mm_movehl_ps(uvLo, xyLo));
+    _mm_storeu_ps(&out[2 * 4 + corner].x, _mm_movelh_ps(xyHi, uvHi));
+    _mm_storeu_ps(&out[3 * 4 + corner].x, _mm_movehl_ps(uvHi, xyHi));
+}
+
+static void buildQuadsSse2(const QuadInputs& in, size_t begin, size_t end, Vertex* out, float textureSlot) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const __m128 a = _mm_loadu_ps(in.a + i);
+        const __m128 b = _mm_loadu_ps(in.b + i);
+        const __m128 c = _mm_loadu_ps(in.c + i);
+        const __m128 d = _mm_loadu_ps(in.d + i);
+        const __m128 w = _mm_loadu_ps(in.w + i);
+        const __m128 h = _mm_loadu_ps(in.h + i);
+
+        const __m128 sx = _mm_mul_ps(_mm_loadu_ps(in.pivotX + i), _mm_sub_ps(one, w));
+        const __m128 sy = _mm_mul_ps(_mm_loadu_ps(in.pivotY + i), _mm_sub_ps(one, h));
+        const __m128 qx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, sx), _mm_mul_ps(c, sy)), _mm_loadu_ps(in.x + i));
+        const __m128 qy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(b, sx), _mm_mul_ps(d, sy)), _mm_loadu_ps(in.y + i));
+        const __m128 qa = _mm_mul_ps(a, w);
+        const __m128 qb = _mm_mul_ps(b, w);
+        const __m128 qc = _mm_mul_ps(c, h);
+        const __m128 qd = _mm_mul_ps(d, h);
+
+        const __m128 tlx = _mm_add_ps(qc, qx);
+        const __m128 tly = _mm_add_ps(qd, qy);
+        const __m128 u0 = _mm_loadu_ps(in.u0 + i);
+        const __m128 v0 = _mm_loadu_ps(in.v0 + i);
+        const __m128 u1 = _mm_loadu_ps(in.u1 + i);
+        const __m128 v1 = _mm_loadu_ps(in.v1 + i);
+
+        Vertex* quads = out + i * 4;
+        storeCornerSse2(quads, 0, tlx, tly, u0, v1);
+        storeCornerSse2(quads, 1, _mm_add_ps(qa, tlx), _mm_add_ps(qb, tly), u1, v1);
+        storeCornerSse2(quads, 2, _mm_add_ps(qa, qx), _mm_add_ps(qb, qy), u1, v0);
+        storeCornerSse2(quads, 3, qx, qy, u0, v0);
+        for (size_t j = 0; j < 4; j++) {
+            setQuadColor(quads + j * 4, in.colors[i + j], textureSlot);
+        }
+    }
+    buildQuadsScalar(in, i, end, out, textureSlot);
+}
+
+#endif
+
+#if GMI_QUAD_AVX2
+
+__attribute__((target("avx2"))) static void buildQuadsAvx2(const QuadInputs& in, size_t begin, size_t end, Vertex* out, float textureSlot) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        const __m256 a = _mm256_loadu_ps(in.a + i);
+        const __m256 b = _mm256_loadu_ps(in.b + i);
+        const __m256 c = _mm256_loadu_ps(in.c + i);
+        const __m256 d = _mm256_loadu_ps(in.d + i);
+        const __m256 w = _mm256_loadu_ps(in.w + i);
+        const __m256 h = _mm256_loadu_ps(in.h + i);
+
+        const __m256 sx = _mm256_mul_ps(_mm256_loadu_ps(in.pivotX + i), _mm256_sub_ps(one, w));
+        const __m256 sy = _mm256_mul_ps(_mm256_loadu_ps(in.pivotY + i), _mm256_sub_ps(one, h));
+        const __m256 qx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, sx), _mm256_mul_ps(c, sy)), _mm256_loadu_ps(in.x + i));
+        const __m256 qy = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(b, sx), _mm256_mul_ps(d, sy)), _mm256_loadu_ps(in.y + i));
+        const __m256 qa = _mm256_mul_ps(a, w);
+        const __m256 qb = _mm256_mul_ps(b, w);
+        const __m256 qc = _mm256_mul_ps(c, h);
+        const __m256 qd = _mm256_mul_ps(d, h);
+
+        const __m256 tlx = _mm256_add_ps(qc, qx);
+        const __m256 tly = _mm256_add_ps(qd, qy);
+        const __m256 u0 = _mm256_loadu_ps(in.u0 + i);
+        const __m256 v0 = _mm256_loadu_ps(in.v0 + i);
+        const __m256 u1 = _mm256_loadu_ps(in.u1 + i);
+        const __m256 v1 = _mm256_loadu_ps(in.v1 + i);
+
+        // corner x, y, u, v of all 8 quads
+        const __m256 corners[4][4] = {
+            {tlx, tly, u0, v1},
+            {_mm256_add_ps(qa, tlx), _mm256_add_ps(qb, tly), u1, v1},
+            {_mm256_add_ps(qa, qx), _mm256_add_ps(qb, qy), u1, v0},
+            {qx, qy, u0, v0},
+        };
+
+        // the interleaving happens within 128-bit lanes, so each lane stores 4 quads
+        Vertex* quads = out + i * 4;
+        for (int corner = 0; corner < 4; corner++) {
+            const __m256 xyLo = _mm256_unpacklo_ps(corners[corner][0], corners[corner][1]);
+            const __m256 xyHi = _mm256_unpackhi_ps(corners[corner][0], corners[corner][1]);
+            const __m256 uvLo = _mm256_unpacklo_ps(corners[corner][2], corners[corner][3]);
+            const __m256 uvHi = _mm256_unpackhi_ps(corners[corner][2], corners[corner][3]);
+            const __m256 q0 = _mm256_shuffle_ps(xyLo, uvLo, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 q1 = _mm256_shuffle_ps(xyLo, uvLo, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 q2 = _mm256_shuffle_ps(xyHi, uvHi, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 q3 = _mm256_shuffle_ps(xyHi, uvHi, _MM_SHUFFLE(3, 2, 3, 2));
+            _mm_storeu_ps(&quads[0 * 4 + corner].x, _mm256_castps256_ps128(q0));
+            _mm_storeu_ps(&quads[1 * 4 + corner].x, _mm256_castps256_ps128(q1));
+            _mm_storeu_ps(&quads[2 * 4 + corner].x, _mm256_castps256_ps128(q2));
+            _mm_storeu_ps(&quads[3 * 4 + corner].x, _mm256_castps256_ps128(q3));
+            _mm_storeu_ps(&quads[4 * 4 + corner].x, _mm256_extractf128_ps(q0, 1));
+            _mm_storeu_ps(&quads[5 * 4 + corner].x, _mm256_extractf128_ps(q1, 1));
+            _mm_storeu_ps(&quads[6 * 4 + corner].x, _mm256_extractf128_ps(q2, 1));
+            _mm_storeu_ps(&quads[7 * 4 + corner].x, _mm256_extractf128_ps(q3, 1));
+        }
+        for (size_t j = 0; j < 8; j++) {
+            setQuadColor(quads + j * 4, in.colors[i + j], textureSlot);
+        }
+    }
+    buildQuadsSse2(in, i, end, out, textureSlot);
+}
+
+#endif
+
+#if GMI_QUAD_NEON
+
+/** Stores one corner of 4 quads, from the corner's x, y, u and v of each quad. */
+static void storeCornerNeon(Vertex* out, int corner, float32x4_t x, float32x4_t y, float32x4_t u, float32x4_t v) {
+    const float32x4x2_t xy = vzipq_f32(x, y);
+    const float32x4x2_t uv = vzipq_f32(u, v);
+    vst1q_f32(&out[0 * 4 + corner].x, vcombine_f32(vget_low_f32(xy.val[0]), vget_low_f32(uv.val[0])));
+    vst1q_f32(&out[1 * 4 + corner].x, vcombine_f32(vget_high_f32(xy.val[0]), vget_high_f32(uv.val[0])));
+    vst1q_f32(&out[2 * 4 + corner].x, vcombine_f32(vget_low_f32(xy.val[1]), vget_low_f32(uv.val[1])));
+    vst1q_f32(&out[3 * 4 + corner].x, vcombine_f32(vget_high_f32(xy.val[1]), vget_high_f32(uv.val[1])));
+}
+
+static void buildQuadsNeon(const QuadInputs& in, size_t begin, size_t end, Vertex* out, float textureSlot) {
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        const float32x4_t a = vld1q_f32(in.a + i);
+        const float32x4_t b = vld1q_f32(in.b + i);
+        const float32x4_t c = vld1q_f32(in.c + i);
+        const float32x4_t d = vld1q_f32(in.d + i);
+        const float32x4_t w = vld1q_f32(in.w + i);
+        const float32x4_t h = vld1q_f32(in.h + i);
+
+        // separate multiplies and adds, which the build keeps from being fused, so results match the scalar kernel
+        const float32x4_t sx = vmulq_f32(vld1q_f32(in.pivotX + i), vsubq_f32(one, w));
+        const float32x4_t sy = vmulq_f32(vld1q_f32(in.pivotY + i), vsubq_f32(one, h));
+        const float32x4_t qx = vaddq_f32(vaddq_f32(vmulq_f32(a, sx), vmulq_f32(c, sy)), vld1q_f32(in.x + i));
+        const float32x4_t qy = vaddq_f32(vaddq_f32(vmulq_f32(b, sx), vmulq_f32(d, sy)), vld1q_f32(in.y + i));
+        const float32x4_t qa = vmulq_f32(a, w);
+        const float32x4_t qb = vmulq_f32(b, w);
+        const float32x4_t qc = vmulq_f32(c, h);
+        const float32x4_t qd = vmulq_f32(d, h);
+
+        const float32x4_t tlx = vaddq_f32(qc, qx);
+        const float32x4_t tly = vaddq_f32(qd, qy);
+        const float32x4_t u0 = vld1q_f32(in.u0 + i);
+        const float32x4_t v0 = vld1q_f32(in.v0 + i);
+        const float32x4_t u1 = vld1q_f32(in.u1 + i);
+        const float32x4_t v1 = vld1q_f32(in.v1 + i);
+
+        Vertex* quads = out + i * 4;
+        storeCornerNeon(quads, 0, tlx, tly, u0, v1);
+        storeCornerNeon(quads, 1, vaddq_f32(qa, tlx), vaddq_f32(qb, tly), u1, v1);
+        storeCornerNeon(quads, 2, vaddq_f32(qa, qx), vaddq_f32(qb, qy), u1, v0);
+        storeCornerNeon(quads, 3, qx, qy, u0, v0);
+        for (size_t j = 0; j < 4; j++) {
+            setQuadColor(quads + j * 4, in.colors[i + j], textureSlot);
+        }
+    }
+    buildQuadsScalar(in, i, end, out, textureSlot);
+}
+
+#endif
+
+std::vector<QuadKernelChoice> supportedQuadKernels() {
+    std::vector<QuadKernelChoice> kernels;
+#if GMI_QUAD_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({buildQuadsAvx2, "AVX2"});
+    }
+#endif
+#if GMI_QUAD_SSE2
+    kernels.push_back({buildQuadsSse2, "SSE2"});
+#elif GMI_QUAD_NEON
+    kernels.push_back({buildQuadsNeon, "NEON"});
+#endif
+    kernels.push_back({buildQuadsScalar, "scalar"});
+    return kernels;
+}
+
+static const QuadKernelChoice& quadKernel() {
+    static const QuadKernelChoice choice = supportedQuadKernels().front();
+    return choice;
+}
+
+void buildQuads(const QuadInputs& in, size_t count, Vertex* out, float textureSlot) {
+    quadKernel().kernel(in, 0, count, out, textureSlot);
+}
+
+const char* quadKernelName() {
+    return quadKernel().name;
+}
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "gmi/client/Affine.h"
+#include "gmi/client/Vertex.h"
+
+namespace gmi::internal {
+
+/**
+ * Inputs of @ref buildQuads(), as parallel arrays with one entry per quad.
+ * Each quad is drawn the same way as a Sprite: the unit square scaled to the frame size about the pivot,
+ * then transformed by the world affine.
+ */
+struct QuadInputs {
+    // World affines
+    const float* a;
+    const float* b;
+    const float* c;
+    const float* d;
+    const float* x;
+    const float* y;
+    // Frame sizes in pixels
+    const float* w;
+    const float* h;
+    // Normalized pivots
+    const float* pivotX;
+    const float* pivotY;
+    // UV rects
+    const float* u0;
+    const float* v0;
+    const float* u1;
+    const float* v1;
+    const Color* colors;
+
+    /** @return The inputs starting at the given quad. */
+    [[nodiscard]] QuadInputs offset(size_t first) const {
+        return {
+            a + first, b + first, c + first, d + first, x + first, y + first,
+            w + first, h + first,
+            pivotX + first, pivotY + first,
+            u0 + first, v0 + first, u1 + first, v1 + first,
+            colors + first,
+        };
+    }
+};
+
+/** Owning storage for @ref QuadInputs, reused between calls to avoid allocations. */
+struct QuadArrays {
+    std::vector<float> a, b, c, d, x, y;
+    std::vector<float> w, h;
+    std::vector<float> pivotX, pivotY;
+    std::vector<float> u0, v0, u1, v1;
+    std::vector<Color> colors;
+
+    void clear();
+    void reserve(size_t count);
+    void push(const math::Affine& world, float frameW, float frameH, math::Vec2f pivot, float uvU0, float uvV0, float uvU1, float uvV1);
+    [[nodiscard]] size_t size() const { return a.size(); }
+    [[nodiscard]] QuadInputs inputs() const;
+};
+
+/**
+ * Writes the four vertices of every quad, in the order top left, top right, bottom right, bottom left.
+ * Quads are processed 8 at a time with AVX2, or 4 at a time with SSE2 or NEON, picked once at runtime.
+ * @param in The quads
+ * @param count The number of quads
+ * @param out Space for 4 vertices per quad
+ * @param textureSlot The texture slot written to every vertex
+ */
+void buildQuads(const QuadInputs& in, size_t count, Vertex* out, float textureSlot = 0);
+
+/** The scalar implementation of @ref buildQuads(), used for remainders and on CPUs without SIMD support. */
+void buildQuadsScalar(const QuadInputs& in, size_t begin, size_t end, Vertex* out, float textureSlot);
+
+/** @return The name of the implementation @ref buildQuads() dispatches to, for diagnostics. */
+const char* quadKernelName();
+
+/** An implementation of @ref buildQuads(), writing the quads from begin to end. */
+using QuadKernel = void (*)(const QuadInputs& in, size_t begin, size_t end, Vertex* out, float textureSlot);
+
+struct QuadKernelChoice {
+    QuadKernel kernel;
+    const char* name;
+};
+
+/**
+ * @return Every implementation the CPU supports, fastest first and ending with the scalar one.
+ * @ref buildQuads() uses the first; all of them produce bit-identical vertices.
+ */
+std::vector<QuadKernelChoice> supportedQuadKernels();
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace gmi::internal {
+
+/**
+ * Sorts items by their 64-bit `key` member with a least significant digit radix sort.
+ * The sort is stable, so items with equal keys keep their relative order.
+ * Passes over digits that are identical for every key are skipped, so keys which only use a few bits are cheap to sort.
+ * @param items The items to sort
+ * @param scratch A buffer reused between calls to avoid allocations
+ */
+template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+void radixSort(std::vector<T>& items, std::vector<T>& scratch) {
+    const size_t n = items.size();
+    if (n < 2) {
+        return;
+    }
+    scratch.resize(n);
+
+    T* src = items.data();
+    T* dst = scratch.data();
+
+    // histograms of all 8 digits are gathered in a single pass
+    uint32_t counts[8][256];
+    std::memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = src[i].key;
+        for (int digit = 0; digit < 8; digit++) {
+            counts[digit][(key >> (digit * 8)) & 0xff]++;
+        }
+    }
+
+    for (int digit = 0; digit < 8; digit++) {
+        uint32_t* count = counts[digit];
+        const int shift = digit * 8;
+        if (count[(src[0].key >> shift) & 0xff] == n) {
+            continue; // every key has the same digit
+        }
+
+        uint32_t offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            uint32_t c = count[bucket];
+            count[bucket] = offset;
+            offset += c;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != items.data()) {
+        std::memcpy(items.data(), src, n * sizeof(T));
+    }
+}
+
+}
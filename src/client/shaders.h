@@ -2,13 +2,30 @@
 
 #include "bgfx/embedded_shader.h"
 
+#include <essl/fs_sprite1.sc.bin.h>
 #include <essl/fs_sprite.sc.bin.h>
+#include <essl/fs_sprite16.sc.bin.h>
 #include <essl/vs_sprite.sc.bin.h>
+#include <glsl/fs_sprite1.sc.bin.h>
 #include <glsl/fs_sprite.sc.bin.h>
+#include <glsl/fs_sprite16.sc.bin.h>
 #include <glsl/vs_sprite.sc.bin.h>
+#include <spirv/fs_sprite1.sc.bin.h>
 #include <spirv/fs_sprite.sc.bin.h>
+#include <spirv/fs_sprite16.sc.bin.h>
 #include <spirv/vs_sprite.sc.bin.h>
 
+#include <essl/vs_sprite_instanced.sc.bin.h>
+#include <glsl/vs_sprite_instanced.sc.bin.h>
+#include <spirv/vs_sprite_instanced.sc.bin.h>
+
+#include <essl/vs_color_compact.sc.bin.h>
+#include <essl/vs_sprite_compact.sc.bin.h>
+#include <glsl/vs_color_compact.sc.bin.h>
+#include <glsl/vs_sprite_compact.sc.bin.h>
+#include <spirv/vs_color_compact.sc.bin.h>
+#include <spirv/vs_sprite_compact.sc.bin.h>
+
 #include <essl/fs_color.sc.bin.h>
 #include <essl/vs_color.sc.bin.h>
 #include <glsl/fs_color.sc.bin.h>
@@ -17,33 +34,61 @@
 #include <spirv/vs_color.sc.bin.h>
 
 #if defined(_WIN32)
+#include <dx11/fs_sprite1.sc.bin.h>
 #include <dx11/fs_sprite.sc.bin.h>
+#include <dx11/fs_sprite16.sc.bin.h>
 #include <dx11/vs_sprite.sc.bin.h>
 
+#include <dx11/vs_sprite_instanced.sc.bin.h>
+
+#include <dx11/vs_color_compact.sc.bin.h>
+#include <dx11/vs_sprite_compact.sc.bin.h>
+
 #include <dx11/fs_color.sc.bin.h>
 #include <dx11/vs_color.sc.bin.h>
 #else
 // makes bgfx embedded shader macro work if dx11 shaders aren't present
+static constexpr uint8_t fs_sprite1_dx11[0] = {};
 static constexpr uint8_t fs_sprite_dx11[0] = {};
+static constexpr uint8_t fs_sprite16_dx11[0] = {};
 static constexpr uint8_t vs_sprite_dx11[0] = {};
 
+static constexpr uint8_t vs_sprite_instanced_dx11[0] = {};
+
+static constexpr uint8_t vs_color_compact_dx11[0] = {};
+static constexpr uint8_t vs_sprite_compact_dx11[0] = {};
+
 static constexpr uint8_t fs_color_dx11[0] = {};
 static constexpr uint8_t vs_color_dx11[0] = {};
 #endif //  defined(_WIN32)
 
 #if __APPLE__
+#include <metal/fs_sprite1.sc.bin.h>
 #include <metal/fs_sprite.sc.bin.h>
+#include <metal/fs_sprite16.sc.bin.h>
 #include <metal/vs_sprite.sc.bin.h>
 
+#include <metal/vs_sprite_instanced.sc.bin.h>
+
+#include <metal/vs_color_compact.sc.bin.h>
+#include <metal/vs_sprite_compact.sc.bin.h>
+
 #include <metal/fs_color.sc.bin.h>
 #include <metal/vs_color.sc.bin.h>
 #endif // __APPLE__
 
 namespace gmi::internal {
 
+const bgfx::EmbeddedShader FS_SPRITE1 = BGFX_EMBEDDED_SHADER(fs_sprite1);
 const bgfx::EmbeddedShader FS_SPRITE = BGFX_EMBEDDED_SHADER(fs_sprite);
+const bgfx::EmbeddedShader FS_SPRITE16 = BGFX_EMBEDDED_SHADER(fs_sprite16);
 const bgfx::EmbeddedShader VS_SPRITE = BGFX_EMBEDDED_SHADER(vs_sprite);
 
+const bgfx::EmbeddedShader VS_SPRITE_INSTANCED = BGFX_EMBEDDED_SHADER(vs_sprite_instanced);
+
+const bgfx::EmbeddedShader VS_COLOR_COMPACT = BGFX_EMBEDDED_SHADER(vs_color_compact);
+const bgfx::EmbeddedShader VS_SPRITE_COMPACT = BGFX_EMBEDDED_SHADER(vs_sprite_compact);
+
 const bgfx::EmbeddedShader FS_COLOR = BGFX_EMBEDDED_SHADER(fs_color);
 const bgfx::EmbeddedShader VS_COLOR = BGFX_EMBEDDED_SHADER(vs_color);
 
@@ -4,6 +4,6 @@ $output v_color0
 #include <bgfx_shader.sh>
 
 void main() {
-    gl_Position = mul(u_viewProj, vec4(a_position, 0.0, 1.0));
+    gl_Position = mul(u_modelViewProj, vec4(a_position, 0.0, 1.0));
     v_color0 = a_color0;
 }
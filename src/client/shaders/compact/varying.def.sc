@@ -0,0 +1,8 @@
+vec2 a_position  : POSITION;
+vec2 a_texcoord0 : TEXCOORD0;
+vec4 a_color0    : COLOR0;
+vec4 a_texcoord1 : TEXCOORD1;
+
+vec2 v_texcoord0 : TEXCOORD0;
+vec4 v_color0    : COLOR0;
+float v_texslot  : TEXCOORD1;
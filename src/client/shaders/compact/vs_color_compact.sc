@@ -0,0 +1,13 @@
+$input a_position, a_color0
+$output v_color0
+
+#include <bgfx_shader.sh>
+
+// xy: origin of the batch, z: size of one position unit in pixels
+uniform vec4 u_batchOrigin;
+
+void main() {
+    vec2 position = a_position * u_batchOrigin.z + u_batchOrigin.xy;
+    gl_Position = mul(u_modelViewProj, vec4(position, 0.0, 1.0));
+    v_color0 = a_color0;
+}
@@ -0,0 +1,16 @@
+$input a_position, a_texcoord0, a_color0, a_texcoord1
+$output v_texcoord0, v_color0, v_texslot
+
+#include <bgfx_shader.sh>
+
+// xy: origin of the batch, z: size of one position unit in pixels
+uniform vec4 u_batchOrigin;
+
+void main() {
+    vec2 position = a_position * u_batchOrigin.z + u_batchOrigin.xy;
+    gl_Position = mul(u_modelViewProj, vec4(position, 0.0, 1.0));
+    v_texcoord0 = a_texcoord0;
+    v_color0 = a_color0;
+    // the slot is a normalized byte, scale it back to the index the float layout carries (COMPACT_SLOT_SCALE)
+    v_texslot = a_texcoord1.x * 255.0;
+}
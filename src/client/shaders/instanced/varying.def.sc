@@ -0,0 +1,8 @@
+vec2 a_position  : POSITION;
+vec4 i_data0     : TEXCOORD7;
+vec4 i_data1     : TEXCOORD6;
+vec4 i_data2     : TEXCOORD5;
+
+vec2 v_texcoord0 : TEXCOORD0;
+vec4 v_color0    : COLOR0;
+float v_texslot  : TEXCOORD1;
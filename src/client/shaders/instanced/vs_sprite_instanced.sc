@@ -0,0 +1,27 @@
+$input a_position, i_data0, i_data1, i_data2
+$output v_texcoord0, v_color0, v_texslot
+
+#include <bgfx_shader.sh>
+
+// i_data0: affine a, b, c, d
+// i_data1: affine x, y, then the UV of the (0, 0) corner
+// i_data2: UV of the (1, 1) corner, packed RGB tint, alpha * 16 + texture slot
+
+void main() {
+    vec2 corner = a_position;
+    vec2 pos = vec2(
+        i_data0.x * corner.x + i_data0.z * corner.y + i_data1.x,
+        i_data0.y * corner.x + i_data0.w * corner.y + i_data1.y
+    );
+    gl_Position = mul(u_modelViewProj, vec4(pos, 0.0, 1.0));
+
+    v_texcoord0 = mix(i_data1.zw, i_data2.xy, corner);
+
+    float rgb = i_data2.z;
+    float red = floor(rgb / 65536.0);
+    float green = floor((rgb - red * 65536.0) / 256.0);
+    float blue = rgb - red * 65536.0 - green * 256.0;
+    float alpha = floor(i_data2.w / 16.0);
+    v_color0 = vec4(red, green, blue, alpha) / 255.0;
+    v_texslot = i_data2.w - alpha * 16.0;
+}
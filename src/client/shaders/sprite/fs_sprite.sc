@@ -1,10 +1,11 @@
-$input v_texcoord0, v_color0
+$input v_texcoord0, v_color0, v_texslot
 
 #include <bgfx_shader.sh>
 
-SAMPLER2D(s_tex, 0);
+#define MAX_TEXTURES 8
+#include "sprite.sh"
 
 void main() {
-    vec4 tex = texture2D(s_tex, v_texcoord0);
+    vec4 tex = sampleSlot(v_texslot, v_texcoord0);
     gl_FragColor = tex * v_color0;
 }
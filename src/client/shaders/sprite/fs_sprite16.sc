@@ -0,0 +1,11 @@
+$input v_texcoord0, v_color0, v_texslot
+
+#include <bgfx_shader.sh>
+
+#define MAX_TEXTURES 16
+#include "sprite.sh"
+
+void main() {
+    vec4 tex = sampleSlot(v_texslot, v_texcoord0);
+    gl_FragColor = tex * v_color0;
+}
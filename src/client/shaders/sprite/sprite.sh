@@ -0,0 +1,50 @@
+// Shared body of the sprite fragment shaders. MAX_TEXTURES must be defined before including this file.
+// Samplers can't be indexed dynamically on every backend, so the texture slot is resolved with a branch chain.
+
+SAMPLER2D(s_tex0, 0);
+#if MAX_TEXTURES > 1
+SAMPLER2D(s_tex1, 1);
+SAMPLER2D(s_tex2, 2);
+SAMPLER2D(s_tex3, 3);
+SAMPLER2D(s_tex4, 4);
+SAMPLER2D(s_tex5, 5);
+SAMPLER2D(s_tex6, 6);
+SAMPLER2D(s_tex7, 7);
+#endif
+#if MAX_TEXTURES > 8
+SAMPLER2D(s_tex8, 8);
+SAMPLER2D(s_tex9, 9);
+SAMPLER2D(s_tex10, 10);
+SAMPLER2D(s_tex11, 11);
+SAMPLER2D(s_tex12, 12);
+SAMPLER2D(s_tex13, 13);
+SAMPLER2D(s_tex14, 14);
+SAMPLER2D(s_tex15, 15);
+#endif
+
+vec4 sampleSlot(float slot, vec2 uv) {
+#if MAX_TEXTURES == 1
+    return texture2D(s_tex0, uv);
+#else
+    if (slot < 0.5) return texture2D(s_tex0, uv);
+    if (slot < 1.5) return texture2D(s_tex1, uv);
+    if (slot < 2.5) return texture2D(s_tex2, uv);
+    if (slot < 3.5) return texture2D(s_tex3, uv);
+    if (slot < 4.5) return texture2D(s_tex4, uv);
+    if (slot < 5.5) return texture2D(s_tex5, uv);
+    if (slot < 6.5) return texture2D(s_tex6, uv);
+#if MAX_TEXTURES > 8
+    if (slot < 7.5) return texture2D(s_tex7, uv);
+    if (slot < 8.5) return texture2D(s_tex8, uv);
+    if (slot < 9.5) return texture2D(s_tex9, uv);
+    if (slot < 10.5) return texture2D(s_tex10, uv);
+    if (slot < 11.5) return texture2D(s_tex11, uv);
+    if (slot < 12.5) return texture2D(s_tex12, uv);
+    if (slot < 13.5) return texture2D(s_tex13, uv);
+    if (slot < 14.5) return texture2D(s_tex14, uv);
+    return texture2D(s_tex15, uv);
+#else
+    return texture2D(s_tex7, uv);
+#endif
+#endif
+}
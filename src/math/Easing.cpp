@@ -0,0 +1,195 @@
+#include "gmi/math/Easing.h"
+
+#include <algorithm>
+
+namespace gmi::math {
+
+namespace {
+
+/** The number of intervals a table starts with before being refined. */
+constexpr uint32_t MIN_INTERVALS = 64;
+
+template<int D>
+constexpr float ipow(float t) {
+    float result = t;
+    for (int i = 1; i < D; i++) {
+        result *= t;
+    }
+    return result;
+}
+
+template<int D>
+void polyIn(std::span<const float> t, std::span<float> out) {
+    for (size_t i = 0; i < t.size(); i++) {
+        out[i] = ipow<D>(t[i]);
+    }
+}
+
+template<int D>
+void polyOut(std::span<const float> t, std::span<float> out) {
+    for (size_t i = 0; i < t.size(); i++) {
+        out[i] = 1.0f - ipow<D>(1.0f - t[i]);
+    }
+}
+
+template<int D>
+void polyInOut(std::span<const float> t, std::span<float> out) {
+    constexpr float c = static_cast<float>(1 << (D - 1));
+    for (size_t i = 0; i < t.size(); i++) {
+        const float in = c * ipow<D>(t[i]);
+        const float outValue = 1.0f - c * ipow<D>(1.0f - t[i]);
+        out[i] = t[i] < 0.5f ? in : outValue;
+    }
+}
+
+void each(EasingFn fn, std::span<const float> t, std::span<float> out) {
+    for (size_t i = 0; i < t.size(); i++) {
+        out[i] = fn(t[i]);
+    }
+}
+
+}
+
+void ease(EasingId id, std::span<const float> t, std::span<float> out) {
+    constexpr float sqrt3 = std::numbers::sqrt3_v<float>;
+    switch (id) {
+    case EasingId::Linear:
+        std::copy(t.begin(), t.end(), out.begin());
+        break;
+    case EasingId::QuadraticIn: polyIn<2>(t, out); break;
+    case EasingId::QuadraticOut: polyOut<2>(t, out); break;
+    case EasingId::QuadraticInOut: polyInOut<2>(t, out); break;
+    case EasingId::CubicIn: polyIn<3>(t, out); break;
+    case EasingId::CubicOut: polyOut<3>(t, out); break;
+    case EasingId::CubicInOut: polyInOut<3>(t, out); break;
+    case EasingId::QuarticIn: polyIn<4>(t, out); break;
+    case EasingId::QuarticOut: polyOut<4>(t, out); break;
+    case EasingId::QuarticInOut: polyInOut<4>(t, out); break;
+    case EasingId::QuinticIn: polyIn<5>(t, out); break;
+    case EasingId::QuinticOut: polyOut<5>(t, out); break;
+    case EasingId::QuinticInOut: polyInOut<5>(t, out); break;
+    case EasingId::SexticIn: polyIn<6>(t, out); break;
+    case EasingId::SexticOut: polyOut<6>(t, out); break;
+    case EasingId::SexticInOut: polyInOut<6>(t, out); break;
+    case EasingId::BackIn:
+        for (size_t i = 0; i < t.size(); i++) {
+            out[i] = (sqrt3 * (t[i] - 1) + t[i]) * t[i] * t[i];
+        }
+        break;
+    case EasingId::BackOut:
+        for (size_t i = 0; i < t.size(); i++) {
+            const float u = t[i] - 1;
+            out[i] = 1.0f + ((sqrt3 + 1) * t[i] - 1) * u * u;
+        }
+        break;
+    case EasingId::BackInOut:
+        for (size_t i = 0; i < t.size(); i++) {
+            const float u = t[i] - 1;
+            const float in = 4.0f * t[i] * t[i] * (3.6f * t[i] - 1.3f);
+            const float outValue = 4 * u * u * (3.6f * t[i] - 2.3f) + 1.0f;
+            out[i] = t[i] < 0.5f ? in : outValue;
+        }
+        break;
+    default:
+        each(getEasingFn(id), t, out);
+        break;
+    }
+}
+
+EasingTables::EasingTables(float maxError) : m_maxError(maxError) { }
+
+bool EasingTables::usesTable(EasingId id) const {
+    if (m_maxError <= 0) {
+        return false;
+    }
+    switch (id) {
+    case EasingId::SineIn:
+    case EasingId::SineOut:
+    case EasingId::SineInOut:
+    case EasingId::ElasticIn:
+    case EasingId::ElasticOut:
+    case EasingId::ElasticInOut:
+    case EasingId::ElasticOut2:
+    case EasingId::ExpoIn:
+    case EasingId::ExpoOut:
+    case EasingId::ExpoInOut:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void EasingTables::setMaxError(float maxError) {
+    m_maxError = maxError;
+    for (Table& table : m_tables) {
+        table = {};
+    }
+}
+
+const EasingTables::Table& EasingTables::getTable(EasingId id) {
+    Table& table = m_tables[static_cast<size_t>(id)];
+    if (!table.samples.empty()) {
+        return table;
+    }
+
+    const EasingFn fn = getEasingFn(id);
+    table.start = fn(0);
+    table.end = fn(1);
+
+    std::vector<float>& samples = table.samples;
+    uint32_t intervals = MIN_INTERVALS;
+    samples.resize(intervals + 1);
+    for (uint32_t i = 1; i < intervals; i++) {
+        samples[i] = fn(static_cast<float>(i) / static_cast<float>(intervals));
+    }
+
+    // the midpoints checked against the interpolated values are the new samples if the table needs refining
+    std::vector<float> midpoints;
+    while (true) {
+        samples[0] = 2 * samples[1] - samples[2];
+        samples[intervals] = 2 * samples[intervals - 1] - samples[intervals - 2];
+
+        midpoints.resize(intervals);
+        float error = 0;
+        for (uint32_t i = 0; i < intervals; i++) {
+            midpoints[i] = fn((static_cast<float>(i) + 0.5f) / static_cast<float>(intervals));
+            error = std::max(error, std::abs(midpoints[i] - (samples[i] + samples[i + 1]) * 0.5f));
+        }
+        // the extrapolated samples are furthest off right next to 0 and 1
+        const float near = 1.0f / static_cast<float>(intervals * 1024);
+        error = std::max(error, std::abs(fn(near) - lerp(samples[0], samples[1], 1.0f / 1024)));
+        error = std::max(error, std::abs(fn(1 - near) - lerp(samples[intervals - 1], samples[intervals], 1 - 1.0f / 1024)));
+        if (error <= m_maxError || intervals >= MAX_INTERVALS) {
+            break;
+        }
+
+        std::vector<float> refined(intervals * 2 + 1);
+        for (uint32_t i = 0; i < intervals; i++) {
+            refined[i * 2] = samples[i];
+            refined[i * 2 + 1] = midpoints[i];
+        }
+        samples = std::move(refined);
+        intervals *= 2;
+    }
+    return table;
+}
+
+void EasingTables::ease(EasingId id, std::span<const float> t, std::span<float> out) {
+    if (!usesTable(id)) {
+        math::ease(id, t, out);
+        return;
+    }
+
+    const Table& table = getTable(id);
+    const float* samples = table.samples.data();
+    const auto intervals = static_cast<uint32_t>(table.samples.size() - 1);
+    const auto scale = static_cast<float>(intervals);
+    for (size_t i = 0; i < t.size(); i++) {
+        const float x = std::clamp(t[i], 0.0f, 1.0f) * scale;
+        const uint32_t index = std::min(static_cast<uint32_t>(x), intervals - 1);
+        const float value = lerp(samples[index], samples[index + 1], x - static_cast<float>(index));
+        out[i] = t[i] <= 0 ? table.start : t[i] >= 1 ? table.end : value;
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+#include "gmi/math/RectPacker.h"
+
+namespace gmi::math {
+
+RectPacker::RectPacker(uint32_t width, uint32_t height) :
+    m_width(width), m_height(height) {
+    clear();
+}
+
+void RectPacker::clear() {
+    m_skyline.assign(1, {0, 0, m_width});
+    m_usedArea = 0;
+}
+
+std::optional<uint32_t> RectPacker::fit(size_t i, uint32_t w, uint32_t h) const {
+    const uint32_t x = m_skyline[i].x;
+    if (x + w > m_width) {
+        return std::nullopt;
+    }
+
+    // the rectangle rests on the highest segment below it
+    uint32_t y = 0;
+    uint32_t remaining = w;
+    for (size_t j = i; remaining > 0; j++) {
+        y = std::max(y, m_skyline[j].y);
+        if (y + h > m_height) {
+            return std::nullopt;
+        }
+        remaining -= std::min(remaining, m_skyline[j].w);
+    }
+    return y;
+}
+
+std::optional<UintRect> RectPacker::insert(uint32_t w, uint32_t h) {
+    if (w == 0 || h == 0) {
+        return UintRect{0, 0, w, h};
+    }
+
+    // lowest top edge wins, ties go to the narrowest segment to keep wide ones for wide rectangles
+    size_t bestIndex = m_skyline.size();
+    uint32_t bestTop = UINT32_MAX, bestWidth = UINT32_MAX;
+    for (size_t i = 0; i < m_skyline.size(); i++) {
+        std::optional<uint32_t> y = fit(i, w, h);
+        if (!y.has_value()) {
+            continue;
+        }
+        const uint32_t top = *y + h;
+        if (top < bestTop || (top == bestTop && m_skyline[i].w < bestWidth)) {
+            bestIndex = i;
+            bestTop = top;
+            bestWidth = m_skyline[i].w;
+        }
+    }
+    if (bestIndex == m_skyline.size()) {
+        return std::nullopt;
+    }
+
+    const UintRect rect{m_skyline[bestIndex].x, bestTop - h, w, h};
+
+    // the new segment replaces the part of the skyline it covers
+    m_skyline.insert(m_skyline.begin() + static_cast<std::ptrdiff_t>(bestIndex), {rect.x, bestTop, w});
+    const uint32_t right = rect.x + w;
+    size_t next = bestIndex + 1;
+    while (next < m_skyline.size() && m_skyline[next].x < right) {
+        Segment& segment = m_skyline[next];
+        const uint32_t segmentRight = segment.x + segment.w;
+        if (segmentRight <= right) {
+            m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(next));
+            continue;
+        }
+        segment.w = segmentRight - right;
+        segment.x = right;
+        break;
+    }
+
+    // neighbours at the same height are merged, which keeps the skyline short
+    for (size_t i = 0; i + 1 < m_skyline.size();) {
+        if (m_skyline[i].y == m_skyline[i + 1].y) {
+            m_skyline[i].w += m_skyline[i + 1].w;
+            m_skyline.erase(m_skyline.begin() + static_cast<std::ptrdiff_t>(i + 1));
+        } else {
+            i++;
+        }
+    }
+
+    m_usedArea += static_cast<uint64_t>(w) * h;
+    return rect;
+}
+
+}
@@ -0,0 +1,54 @@
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "gmi/math/Easing.h"
+
+using gmi::math::EasingId;
+
+int main() {
+    constexpr size_t count = 10001;
+    std::vector<float> t(count);
+    for (size_t i = 0; i < count; i++) {
+        t[i] = static_cast<float>(i) / static_cast<float>(count - 1);
+    }
+    std::vector<float> out(count);
+
+    // the batch forms match the scalar functions
+    for (size_t e = 0; e < static_cast<size_t>(EasingId::Count); e++) {
+        const auto id = static_cast<EasingId>(e);
+        gmi::math::ease(id, t, out);
+        for (size_t i = 0; i < count; i++) {
+            assert(std::abs(out[i] - gmi::math::getEasingFn(id)(t[i])) <= 1e-5f);
+        }
+    }
+
+    // tables stay within their error bound, and hit both ends exactly
+    for (const float maxError : {1e-3f, 1e-4f}) {
+        gmi::math::EasingTables tables(maxError);
+        for (size_t e = 0; e < static_cast<size_t>(EasingId::Count); e++) {
+            const auto id = static_cast<EasingId>(e);
+            tables.ease(id, t, out);
+            for (size_t i = 0; i < count; i++) {
+                assert(std::abs(out[i] - gmi::math::getEasingFn(id)(t[i])) <= maxError);
+            }
+            assert(out.front() == gmi::math::getEasingFn(id)(0.0f));
+            assert(out.back() == gmi::math::getEasingFn(id)(1.0f));
+        }
+    }
+
+    // a zero bound disables the tables
+    gmi::math::EasingTables exact(0);
+    assert(!exact.usesTable(EasingId::SineIn));
+    exact.ease(EasingId::ElasticOut, t, out);
+    for (size_t i = 0; i < count; i++) {
+        assert(out[i] == gmi::math::Easing::elasticOut(t[i]));
+    }
+
+    // easing in place
+    std::vector<float> values = t;
+    gmi::math::ease(EasingId::CubicInOut, values, values);
+    assert(std::abs(values[2500] - gmi::math::Easing::cubicInOut(0.25f)) <= 1e-6f);
+
+    return 0;
+}
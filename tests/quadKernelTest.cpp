@@ -0,0 +1,90 @@
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "quadKernel.h"
+
+using gmi::Vertex;
+using namespace gmi::internal;
+
+/** Deterministic values in [min, max), so every run tests the same quads. */
+class Values {
+public:
+    float next(float min, float max) {
+        m_state = m_state * 1664525u + 1013904223u;
+        return min + static_cast<float>(m_state >> 8) / static_cast<float>(1 << 24) * (max - min);
+    }
+private:
+    uint32_t m_state = 12345;
+};
+
+static bool sameVertex(const Vertex& a, const Vertex& b) {
+    return a.x == b.x && a.y == b.y && a.u == b.u && a.v == b.v && a.color.r == b.color.r && a.color.g == b.color.g
+        && a.color.b == b.color.b && a.color.a == b.color.a && a.textureSlot == b.textureSlot;
+}
+
+int main() {
+    constexpr size_t maxCount = 257;
+    Values values;
+    QuadArrays arrays;
+    for (size_t i = 0; i < maxCount; i++) {
+        // rotated, sheared and scaled affines, so every product of the kernel matters
+        const gmi::math::Affine world{
+            .a = values.next(-2, 2),
+            .b = values.next(-2, 2),
+            .c = values.next(-2, 2),
+            .d = values.next(-2, 2),
+            .x = values.next(-5000, 5000),
+            .y = values.next(-5000, 5000),
+            .color = {static_cast<uint8_t>(i), static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 13), 255},
+        };
+        const float u0 = values.next(0, 0.5f);
+        const float v0 = values.next(0, 0.5f);
+        arrays.push(
+            world,
+            values.next(1, 512),
+            values.next(1, 512),
+            {values.next(0, 1), values.next(0, 1)},
+            u0,
+            v0,
+            u0 + values.next(0, 0.5f),
+            v0 + values.next(0, 0.5f)
+        );
+    }
+    const QuadInputs inputs = arrays.inputs();
+
+    const std::vector<QuadKernelChoice> kernels = supportedQuadKernels();
+    assert(!kernels.empty());
+    assert(std::string_view(kernels.front().name) == quadKernelName());
+
+    // every supported kernel matches the scalar one bit for bit, whatever the remainder
+    std::vector<Vertex> expected(maxCount * 4);
+    std::vector<Vertex> actual(maxCount * 4);
+    for (const QuadKernelChoice& choice : kernels) {
+        for (size_t begin : {0, 3}) {
+            for (size_t end = begin; end <= maxCount; end++) {
+                expected.assign(maxCount * 4, Vertex{});
+                actual.assign(maxCount * 4, Vertex{});
+                buildQuadsScalar(inputs, begin, end, expected.data(), 3);
+                choice.kernel(inputs, begin, end, actual.data(), 3);
+                for (size_t v = 0; v < maxCount * 4; v++) {
+                    assert(sameVertex(actual[v], expected[v]));
+                }
+            }
+        }
+    }
+
+    // the dispatching entry point writes the same quads
+    for (size_t count = 0; count <= maxCount; count++) {
+        expected.assign(maxCount * 4, Vertex{});
+        actual.assign(maxCount * 4, Vertex{});
+        buildQuadsScalar(inputs, 0, count, expected.data(), 0);
+        buildQuads(inputs, count, actual.data());
+        for (size_t v = 0; v < maxCount * 4; v++) {
+            assert(sameVertex(actual[v], expected[v]));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <cassert>
+#include <vector>
+
+#include "gmi/math/RectPacker.h"
+
+static bool overlaps(const gmi::math::UintRect& a, const gmi::math::UintRect& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+}
+
+int main() {
+    gmi::math::RectPacker packer(256, 256);
+
+    // the first rectangle goes in the bottom left corner
+    const auto first = packer.insert(100, 50);
+    assert(first.has_value());
+    assert(first->x == 0 && first->y == 0);
+
+    // the next one fits beside it rather than on top
+    const auto second = packer.insert(100, 30);
+    assert(second.has_value());
+    assert(second->x == 100 && second->y == 0);
+
+    // too large for the area
+    assert(!packer.insert(257, 10).has_value());
+    assert(!packer.insert(10, 257).has_value());
+
+    // fill the rest with small rectangles, none of which may overlap or leave the area
+    std::vector<gmi::math::UintRect> placed = {*first, *second};
+    while (auto rect = packer.insert(24, 20)) {
+        assert(rect->x + rect->w <= 256 && rect->y + rect->h <= 256);
+        for (const auto& other : placed) {
+            assert(!overlaps(*rect, other));
+        }
+        placed.push_back(*rect);
+    }
+    assert(placed.size() > 100);
+    assert(packer.usedArea() <= 256 * 256);
+
+    // clearing makes the whole area available again
+    packer.clear();
+    assert(packer.usedArea() == 0);
+    const auto full = packer.insert(256, 256);
+    assert(full.has_value());
+    assert(!packer.insert(1, 1).has_value());
+
+    return 0;
+}
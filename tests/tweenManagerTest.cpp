@@ -0,0 +1,164 @@
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+#include "gmi/client/TweenManager.h"
+
+using gmi::TweenHandle;
+using gmi::TweenManager;
+using gmi::TweenOptions;
+
+static bool near(float a, float b) {
+    return std::abs(a - b) <= 1e-4f;
+}
+
+static float squared(float t) {
+    return t * t;
+}
+
+int main() {
+    // a finished tween's handle is stale, and killing it does nothing
+    {
+        TweenManager tweens;
+        tweens.update(0);
+        float x = 0;
+        int completed = 0;
+        const TweenHandle handle = tweens.add({
+            .values = {{&x, 10}},
+            .duration = 100,
+            .onComplete = [&] { completed++; },
+        });
+        assert(handle.isValid() && tweens.isActive(handle));
+        tweens.update(50);
+        assert(near(x, 5));
+        tweens.update(100);
+        assert(x == 10 && completed == 1);
+        assert(!tweens.isActive(handle) && !tweens.kill(handle));
+        tweens.update(200);
+        assert(completed == 1 && tweens.size() == 0);
+
+        // a new tween reusing the slot doesn't answer to the old handle
+        const TweenHandle reused = tweens.add({.values = {{&x, 0}}, .duration = 100});
+        assert(reused != handle && !tweens.isActive(handle) && tweens.isActive(reused));
+    }
+
+    // a killed tween's handle is stale, and its values stay where they are
+    {
+        TweenManager tweens;
+        tweens.update(0);
+        float x = 0;
+        const TweenHandle handle = tweens.add({.values = {{&x, 10}}, .duration = 100});
+        tweens.update(50);
+        assert(tweens.kill(handle));
+        assert(!tweens.kill(handle) && !tweens.isActive(handle) && tweens.size() == 0);
+        tweens.update(100);
+        assert(near(x, 5));
+    }
+
+    // generations wrap around without ever producing the invalid handle
+    {
+        TweenManager tweens;
+        float x = 0;
+        const TweenHandle first = tweens.add({.values = {{&x, 1}}, .duration = 100});
+        TweenHandle previous = first;
+        uint32_t cycle = 0;
+        for (uint32_t i = 1; i < 2048; i++) {
+            assert(tweens.kill(previous));
+            const TweenHandle handle = tweens.add({.values = {{&x, 1}}, .duration = 100});
+            assert(handle.isValid() && handle != previous);
+            assert(tweens.isActive(handle) && !tweens.isActive(previous));
+            if (cycle == 0 && handle == first) {
+                cycle = i;
+            }
+            previous = handle;
+            if (i % 256 == 0) {
+                tweens.update(0);
+            }
+        }
+        // every generation but the invalid one is used before the first comes back
+        assert(cycle == 1023);
+    }
+
+    // a tween killed and a tween added by a callback in the same update
+    {
+        TweenManager tweens;
+        tweens.update(0);
+        float x = 0, y = 0, z = 0;
+        TweenHandle victim;
+        TweenHandle added;
+        int victimUpdates = 0;
+        const TweenHandle killer = tweens.add({
+            .values = {{&x, 10}},
+            .duration = 100,
+            .onUpdate = [&] {
+                if (!added.isValid()) {
+                    assert(tweens.kill(victim));
+                    added = tweens.add({.values = {{&z, 10}}, .duration = 100});
+                }
+            },
+        });
+        victim = tweens.add({.values = {{&y, 10}}, .duration = 100, .onUpdate = [&] { victimUpdates++; }});
+
+        tweens.update(50);
+        // the victim's callbacks don't run once it's killed, and the new tween starts at the time of this update
+        assert(victimUpdates == 0);
+        assert(!tweens.isActive(victim) && tweens.isActive(added) && tweens.isActive(killer));
+        assert(added != victim && tweens.size() == 2);
+        assert(z == 0);
+
+        tweens.update(100);
+        assert(x == 10 && near(y, 5) && near(z, 5));
+        assert(!tweens.isActive(killer) && tweens.isActive(added));
+        tweens.update(150);
+        assert(z == 10 && !tweens.isActive(added) && tweens.size() == 0);
+    }
+
+    // yoyo tweens reach their end values, then come back to their start
+    {
+        TweenManager tweens;
+        tweens.update(0);
+        float x = 0;
+        const TweenHandle handle = tweens.add({.values = {{&x, 10}}, .duration = 100, .yoyo = true});
+        tweens.update(100);
+        assert(x == 10 && tweens.isActive(handle));
+        tweens.update(150);
+        assert(near(x, 5));
+        tweens.update(200);
+        assert(x == 0 && !tweens.isActive(handle));
+
+        float y = 2;
+        const TweenHandle infinite = tweens.add({
+            .values = {{&y, 4}},
+            .duration = 100,
+            .yoyo = true,
+            .infinite = true,
+        });
+        tweens.update(300);
+        assert(y == 4);
+        tweens.update(400);
+        assert(y == 2);
+        tweens.update(500);
+        assert(y == 4 && tweens.isActive(infinite));
+    }
+
+    // custom easings stay with their tween while dead tweens are compacted away
+    {
+        TweenManager tweens;
+        tweens.update(0);
+        float a = 0, b = 0, c = 0, d = 0;
+        const TweenHandle first = tweens.add({.values = {{&a, 10}}, .duration = 100});
+        tweens.add({.values = {{&b, 10}}, .duration = 100, .ease = squared});
+        const TweenHandle third = tweens.add({.values = {{&c, 10}}, .duration = 100, .ease = squared});
+        tweens.add({.values = {{&d, 10}}, .duration = 100, .ease = [](float t) { return 1.0f - (1.0f - t) * (1.0f - t); }});
+        assert(tweens.kill(first) && tweens.kill(third));
+
+        tweens.update(50);
+        assert(a == 0 && c == 0);
+        assert(near(b, 2.5f) && near(d, 7.5f));
+        tweens.update(75);
+        assert(near(b, 10 * squared(0.75f)) && near(d, 10 * (1.0f - 0.25f * 0.25f)));
+        assert(tweens.size() == 2);
+    }
+
+    return 0;
+}